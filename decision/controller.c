@@ -0,0 +1,1313 @@
+// controller.c — decision logic of the master (inverse-model search over the A/F grid)
+// No libpynq in here: main.c sends the commanded cell to the motor node, the simulator moves its plant.
+
+#include "controller.h"
+#include "plant.h"
+#include "policy_table.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CTRL_LOG(s, ...)      \
+  do                          \
+  {                           \
+    if ((s)->log)             \
+      (s)->log(__VA_ARGS__);  \
+  } while (0)
+
+static void belief_reset(controller_state *s);
+
+void controller_init(controller_state *s)
+{
+  memset(s, 0, sizeof(*s)); // anchor map empty, no panic, no log sink
+
+  // start at A5 F5
+  s->curA = 4;
+  s->curF = 4;
+  s->prevA = s->curA;
+  s->prevF = s->curF;
+  s->lastMoveDir = 0;
+
+  s->is_crying_activated = 0;
+  s->lastBPM = -1;
+  s->lastCRY = -1;
+  s->thresholdBPM = 10;
+  s->thresholdCRY = 1;
+
+  s->anchorA_mem = -1;
+  s->anchorF_mem = -1;
+
+  belief_reset(s);
+  s->rng = 0x9E3779B9u;
+  s->policyState = -1;
+}
+
+// Clamp the logical cell (A,F) to the grid, make it current and hand it to the caller to command.
+static void command_cell(controller_state *s, controller_output *out, int aIndex, int fIndex)
+{
+  if (aIndex < 0)
+    aIndex = 0;
+  if (aIndex > 4)
+    aIndex = 4;
+  if (fIndex < 0)
+    fIndex = 0;
+  if (fIndex > 4)
+    fIndex = 4;
+
+  s->moveHarder = (aIndex > s->curA || fIndex > s->curF);
+  s->curA = aIndex;
+  s->curF = fIndex;
+  s->settleMove = 1;
+
+  out->move = 1;
+  out->a = aIndex;
+  out->f = fIndex;
+}
+
+// improvement tests (from sim)
+static int heartbeat_improved(const controller_state *s, int bpm_now)
+{
+  if (s->lastBPM <= 0)
+    return 0;
+  if (s->lastBPM - bpm_now >= s->thresholdBPM)
+    return 1;
+  return 0;
+}
+
+static int crying_improved(const controller_state *s, int cry_now)
+{
+  if (cry_now <= s->thresholdCRY)
+    return 1;
+  if (s->lastCRY > 0 && (s->lastCRY - cry_now >= s->thresholdCRY))
+    return 1;
+  return 0;
+}
+
+// register anchor cell. anchorMatrix holds 10 - level and 0 means "not an anchor", so level 9 (value 1) is
+// the last one: past it a cell would be registered again on every visit. A monotone path has 9 cells anyway.
+static void register_anchor(controller_state *s, int a, int f)
+{
+  if (a < 0 || a > 4 || f < 0 || f > 4)
+    return;
+
+  if (s->anchorMatrix[a][f] == 0 && s->anchorLevel < 9)
+  {
+    s->anchorLevel++;
+    s->anchorMatrix[a][f] = 10 - s->anchorLevel;
+    CTRL_LOG(s, "[A] set A%d F%d as anchor L%d\n",
+               a + 1, f + 1, s->anchorLevel);
+  }
+}
+
+// a probe into (a, f) panicked once: the cell sits two or more K levels below where the search was
+static void mark_bad(controller_state *s, int a, int f)
+{
+  CTRL_LOG(s, "[A] A%d F%d panicked, not probing it again\n", a + 1, f + 1);
+  s->badCells |= 1 << (a * 5 + f);
+}
+
+static int is_bad(const controller_state *s, int a, int f)
+{
+  return a >= 0 && f >= 0 && (s->badCells >> (a * 5 + f) & 1);
+}
+
+// every probe from the anchor tried or known bad: go back to the anchor found before it and try the way
+// from there that does not lead here. The dead end is dropped from the anchors, so a later replay skips it.
+// Returns 0 if there is no anchor before it.
+static int back_from_dead_end(controller_state *s, controller_output *out)
+{
+  int level = s->anchorMatrix[s->curA][s->curF];
+  if (level == 0 || level != 10 - s->anchorLevel || s->anchorLevel < 2)
+    return 0;
+  for (int a = 0; a < 5; a++)
+    for (int f = 0; f < 5; f++)
+      if (s->anchorMatrix[a][f] == level + 1)
+      {
+        CTRL_LOG(s, "[A] dead end at A%d F%d, back to anchor A%d F%d\n", s->curA + 1, s->curF + 1, a + 1, f + 1);
+        s->triedLeftFromAnchor = (s->curA == a && s->curF == f - 1);
+        s->triedUpFromAnchor = (s->curA == a - 1 && s->curF == f);
+        s->anchorMatrix[s->curA][s->curF] = 0;
+        s->anchorLevel--;
+        s->anchorA_mem = s->prevA = a;
+        s->anchorF_mem = s->prevF = f;
+        s->hit_wall = 1; // nothing to judge, only the convergence to wait for
+        command_cell(s, out, a, f);
+        return 1;
+      }
+  return 0;
+}
+
+// TAU ESTIMATE
+// Crying follows the stress right away, BPM follows it TAU later, and between 10 and 50 both are
+// linear in it. Clipped to that range they are the same curve, one shifted by TAU, so the lag with
+// the best correlation between the two series is TAU. It only shows once the stress has moved
+// while both were in range; a flat window says nothing and keeps the last estimate.
+
+#define TAU_MIN_PAIRS 16   // samples that have to overlap at a lag
+#define TAU_MIN_VAR 1.0    // stress variance either series needs to count as moving
+#define TAU_MIN_R2 0.8     // correlation squared the best lag needs
+
+static double clip_stress(double S)
+{
+  return (S < 10.0) ? 10.0 : (S > 50.0) ? 50.0 : S;
+}
+
+void controller_sample(controller_state *s, unsigned t_ms, int bpm, int cry)
+{
+  unsigned char b = (unsigned char)((bpm < 0) ? 0 : (bpm > 255) ? 255 : bpm);
+  unsigned char c = (unsigned char)((cry < 0) ? 0 : (cry > 100) ? 100 : cry);
+  int n = 1;
+  if (s->tauN)
+  {
+    unsigned gap = t_ms - s->tauLastMs;
+    if (gap < TAU_SAMPLE_MS)
+      return;
+    n = (gap / TAU_SAMPLE_MS > TAU_HIST) ? TAU_HIST : (int)(gap / TAU_SAMPLE_MS);
+    s->tauLastMs += (unsigned)n * TAU_SAMPLE_MS;
+  }
+  else
+    s->tauLastMs = t_ms;
+  s->sinceStep += n;
+
+  // a late caller repeats the newest sample for the slots it missed
+  while (n--)
+  {
+    int i = (s->tauHead + s->tauN) % TAU_HIST;
+    if (s->tauN < TAU_HIST)
+      s->tauN++;
+    else
+      s->tauHead = (s->tauHead + 1) % TAU_HIST;
+    s->tauBpm[i] = b;
+    s->tauCry[i] = c;
+  }
+}
+
+static void tau_update(controller_state *s)
+{
+  double x[TAU_HIST], y[TAU_HIST]; // clipped stress from crying and from BPM, oldest first
+  int n = s->tauN;
+  for (int i = 0; i < n; i++)
+  {
+    int j = (s->tauHead + i) % TAU_HIST;
+    x[i] = clip_stress((s->tauCry[j] + 25) / 2.5);
+    y[i] = clip_stress((s->tauBpm[j] - 60) / 1.8);
+  }
+
+  int best = 0;
+  double best_r2 = TAU_MIN_R2;
+  for (int lag = TAU_MIN_MS / TAU_SAMPLE_MS; lag <= TAU_MAX_MS / TAU_SAMPLE_MS; lag++)
+  {
+    int m = n - lag;
+    if (m < TAU_MIN_PAIRS)
+      break;
+    double sx = 0.0, sy = 0.0, sxx = 0.0, syy = 0.0, sxy = 0.0;
+    for (int i = lag; i < n; i++)
+    {
+      double a = x[i - lag], b = y[i];
+      sx += a;
+      sy += b;
+      sxx += a * a;
+      syy += b * b;
+      sxy += a * b;
+    }
+    double vx = sxx / m - (sx / m) * (sx / m);
+    double vy = syy / m - (sy / m) * (sy / m);
+    double cov = sxy / m - (sx / m) * (sy / m);
+    if (vx < TAU_MIN_VAR || vy < TAU_MIN_VAR || cov <= 0.0)
+      continue;
+    double r2 = cov * cov / (vx * vy);
+    if (r2 > best_r2)
+    {
+      best_r2 = r2;
+      best = lag;
+    }
+  }
+
+  if (best && best * TAU_SAMPLE_MS != s->tauMs)
+  {
+    s->tauMs = best * TAU_SAMPLE_MS;
+    CTRL_LOG(s, "[TAU] %d ms (r2 %.2f)\n", s->tauMs, best_r2);
+  }
+}
+
+// TAU plus convergence: how long a move takes to show in the BPM
+static int heartbeat_delay_ms(const controller_state *s)
+{
+  return s->tauMs ? s->tauMs + CONVERGENCE_DELAY + TAU_MARGIN_MS : HEARTBEAT_DELAY;
+}
+
+// SETTLE DETECTOR
+// The wait comes from the move and the signal the next step will read. After a move the plant can
+// only jump once more, when it converges SETTLE_MIN_MS later, and BPM shows that TAU later. Crying has
+// no delay, so once the move has brought it into the range the next step reads it (like the step does,
+// per mode) it is watched instead, even if the step before read BPM. Not if the step got no crying at
+// all: the live master hands it none, so the next step judges on BPM. The newest sample has to be past
+// that last jump and the newest SETTLE_WINDOW_MS flat: a window that still spans the jump is not.
+int controller_settled(const controller_state *s)
+{
+  if (!s->settleMove)
+    return 0;
+  int w = SETTLE_WINDOW_MS / TAU_SAMPLE_MS + 1; // samples in the window
+  if (s->tauN < w)
+    return 0;
+  int cry = s->tauCry[(s->tauHead + s->tauN - 1) % TAU_HIST];
+  int crying = (s->mode == CTRL_MODE_ANCHOR) ? (cry > 15 && cry < 52) : (cry > 0 && cry < 100);
+  crying = crying && s->stepCry > 0;
+  int lag = crying ? 0 : heartbeat_delay_ms(s) - CONVERGENCE_DELAY;
+  if (s->sinceStep <= (lag + SETTLE_MIN_MS) / TAU_SAMPLE_MS || s->sinceStep < w)
+    return 0;
+
+  double st = 0.0, sv = 0.0, stt = 0.0, stv = 0.0;
+  for (int i = 0; i < w; i++)
+  {
+    int j = (s->tauHead + s->tauN - w + i) % TAU_HIST;
+    double t = i * (TAU_SAMPLE_MS / 1000.0);
+    double v = crying ? (s->tauCry[j] + 25) / 2.5 : (s->tauBpm[j] - 60) / 1.8;
+    st += t;
+    sv += v;
+    stt += t * t;
+    stv += t * v;
+  }
+  double slope = (w * stv - st * sv) / (w * stt - st * st);
+  return slope <= SETTLE_SLOPE && slope >= -SETTLE_SLOPE;
+}
+
+// PANIC RECOVERY
+// A panic throws the baby back to K9 but the anchors found on the way down are still good: walk them
+// again in the order they were found (anchorMatrix 9, 8, ...), one per convergence time, without
+// judging any reading. Then resume the search at the last one, where the move that panicked was tried.
+static void recover_step(controller_state *s, controller_output *out)
+{
+  while (s->replayLevel > 1 && s->replayLevel > 10 - s->anchorLevel)
+  {
+    s->replayLevel--;
+    for (int a = 0; a < 5; a++)
+      for (int f = 0; f < 5; f++)
+        if (s->anchorMatrix[a][f] == s->replayLevel && (a != s->curA || f != s->curF))
+        {
+          CTRL_LOG(s, "[R] replay anchor L%d A%d F%d\n", 10 - s->replayLevel, a + 1, f + 1);
+          s->hit_wall = 1; // only the convergence to wait for
+          command_cell(s, out, a, f);
+          return;
+        }
+  }
+
+  CTRL_LOG(s, "[R] anchors replayed, resuming at A%d F%d\n", s->curA + 1, s->curF + 1);
+  s->panic_mode = 0;
+  s->lastMoveDir = 0;
+  if (s->anchorA_mem != s->curA || s->anchorF_mem != s->curF)
+  {
+    s->anchorA_mem = s->curA;
+    s->anchorF_mem = s->curF;
+    s->triedLeftFromAnchor = 0;
+    s->triedUpFromAnchor = 0;
+  }
+}
+
+// WATCHDOG
+// Crying shows a move at once, and after a softer move it can only go up on a panic, which is final
+// right away. So a jump in it between steps does not have to wait out the period. After a harder
+// move it may be a clamp still converging, and BPM cannot tell either: TAU later a clamp looks just
+// like a panic. One reaction per step.
+int controller_watchdog(controller_state *s, controller_output *out)
+{
+  out->move = 0;
+  if (!s->settleMove || s->moveHarder || s->watchFired || !s->is_crying_activated || s->tauN < 2)
+    return 0;
+  // the last two samples, so a read right on the edge of the jump sees it too
+  for (int i = 1; i <= 2; i++)
+    if (s->tauCry[(s->tauHead + s->tauN - i) % TAU_HIST] - s->stepCry < WATCH_CRY)
+      return 0;
+  int cry = s->tauCry[(s->tauHead + s->tauN - 1) % TAU_HIST];
+
+  if (s->mode != CTRL_MODE_ANCHOR)
+  {
+    CTRL_LOG(s, "[W] CRY %d -> %d right after the move, stepping now\n", s->stepCry, cry);
+    s->watchFired = 2;
+    return 1;
+  }
+
+  s->watchFired = 1;
+  if (s->lastMoveDir == 0 || (s->prevA == s->curA && s->prevF == s->curF))
+    return 0; // not a probe, nothing to back out of
+  mark_bad(s, s->curA, s->curF);
+  CTRL_LOG(s, "[W] CRY %d -> %d right after the move, back to A%d F%d\n", s->stepCry, cry, s->prevA + 1, s->prevF + 1);
+  command_cell(s, out, s->prevA, s->prevF);
+  s->lastMoveDir = 0;
+  s->lastBPM = s->tauBpm[(s->tauHead + s->tauN - 1) % TAU_HIST];
+  s->lastCRY = cry;
+  s->sinceStep = 0; // the back-out is the move the next step waits for, like a step's own
+  s->stepCry = cry;
+  return 0;
+}
+
+// SNAPSHOT
+// Only what was learned goes in, not where the search was: a restart can land between a probe and
+// its reading, and nobody knows where the plant is. So a warm start is a panic recovery, which walks
+// the anchors from the top without reading the vitals and probes the last one afresh.
+
+static unsigned char snapshot_sum(const controller_snapshot *snap)
+{
+  const unsigned char *p = (const unsigned char *)snap;
+  unsigned char sum = 0;
+  for (size_t i = 0; i < offsetof(controller_snapshot, check); i++)
+    sum = (unsigned char)(sum + p[i]);
+  return sum;
+}
+
+void controller_save(const controller_state *s, controller_snapshot *snap)
+{
+  memset(snap, 0, sizeof(*snap)); // padding too, so equal states give equal bytes
+  snap->magic = CTRL_SNAPSHOT_MAGIC;
+  snap->tauMs = (unsigned short)s->tauMs;
+  snap->mode = (unsigned char)s->mode;
+  snap->anchorLevel = (unsigned char)s->anchorLevel;
+  for (int i = 0; i < 25; i++)
+    snap->anchorMatrix[i] = (signed char)s->anchorMatrix[i / 5][i % 5];
+  snap->check = snapshot_sum(snap);
+}
+
+int controller_restore(controller_state *s, const controller_snapshot *snap)
+{
+  if (snap->magic != CTRL_SNAPSHOT_MAGIC || snap->check != snapshot_sum(snap) || snap->mode != s->mode)
+    return -1;
+  // same limits register_anchor keeps: at most 9 anchors, stored as 9 .. 1 (0 = none)
+  if (snap->tauMs > TAU_MAX_MS || snap->anchorLevel > 9)
+    return -1;
+  for (int i = 0; i < 25; i++)
+    if (snap->anchorMatrix[i] > 9 || (snap->anchorMatrix[i] != 0 && snap->anchorMatrix[i] < 10 - snap->anchorLevel))
+      return -1;
+
+  s->tauMs = snap->tauMs;
+  if ((s->mode != CTRL_MODE_ANCHOR && s->mode != CTRL_MODE_TABLE) || snap->anchorLevel == 0)
+  {
+    CTRL_LOG(s, "[S] warm start, TAU %d ms\n", s->tauMs);
+    return 0;
+  }
+
+  for (int i = 0; i < 25; i++)
+    s->anchorMatrix[i / 5][i % 5] = snap->anchorMatrix[i];
+  s->anchorLevel = snap->anchorLevel;
+  s->panic_mode = 1;
+  s->replayLevel = 10;
+  CTRL_LOG(s, "[S] warm start, TAU %d ms, replaying %d anchors\n", s->tauMs, s->anchorLevel);
+  return 0;
+}
+
+// BELIEF MODE
+// The inverse model always has K1 at A1 F1 and K9 at A5 F5, joined by a monotone LEFT/UP path
+// (8 moves, 4 of each: 70 paths). Every other cell copies the cell to its right, or else the one
+// below (sim.c build_matrix_from_path). So the path fixes the whole K matrix.
+// Belief mode keeps a probability for each path, updates it after every move (did the reading go
+// down, stay or go up?) and commands the cell with the fewest expected steps to A1 F1 left.
+// Moves that might drop two K levels at once are avoided: a purely softer jump like that can panic.
+
+#define BELIEF_EPS 1e-4  // chance of a reading that contradicts a path (glitch), keeps the belief recoverable
+#define BELIEF_RISK 0.02 // max probability a move drops two or more K levels
+#define BELIEF_TOL 1.5   // settled stress readings this close are the same level
+#define BELIEF_LIVE 1e-6 // paths below this weight are ignored while planning
+
+// K of every cell (index a * 5 + f) for path mask m: bit i = move i from A5 F5, 0 = LEFT, 1 = UP
+static void path_fill_k(int m, unsigned char k[25])
+{
+  memset(k, 0, 25);
+  int a = 4, f = 4;
+  k[24] = 9;
+  for (int i = 0; i < 8; i++)
+  {
+    if ((m >> i) & 1)
+      a--;
+    else
+      f--;
+    k[a * 5 + f] = (unsigned char)(8 - i);
+  }
+
+  // same fill as the sim: from the right along the rows, then from below along the columns
+  for (a = 4; a >= 0; a--)
+    for (f = 3; f >= 0; f--)
+      if (k[a * 5 + f] == 0 && k[a * 5 + f + 1] > 1)
+        k[a * 5 + f] = k[a * 5 + f + 1];
+  for (a = 3; a >= 0; a--)
+    for (f = 4; f >= 0; f--)
+      if (k[a * 5 + f] == 0 && k[(a + 1) * 5 + f] > 1)
+        k[a * 5 + f] = k[(a + 1) * 5 + f];
+}
+
+// every path, weighted like the sim draws them: a coin flip per move until LEFT or UP runs out.
+// the plant starts settled at K9 under all of them
+static void belief_reset(controller_state *s)
+{
+  int n = 0;
+  double total = 0.0;
+  for (int m = 0; m < 256 && n < CTRL_PATHS; m++)
+  {
+    int ups = 0;
+    for (int i = 0; i < 8; i++)
+      ups += (m >> i) & 1;
+    if (ups != 4)
+      continue;
+
+    int left = 4, up = 4;
+    double p = 1.0;
+    for (int i = 0; i < 8; i++)
+    {
+      if (left && up)
+        p *= 0.5;
+      if ((m >> i) & 1)
+        up--;
+      else
+        left--;
+    }
+    s->pathMask[n] = (unsigned char)m;
+    s->belief[n++] = p;
+    total += p;
+  }
+  for (int h = 0; h < CTRL_PATHS; h++)
+  {
+    s->belief[h] /= total;
+    s->level[h] = 9;
+  }
+  memset(s->levelS, 0, sizeof(s->levelS));
+  s->observe = 0;
+}
+
+// settled stress behind this reading. crying is live and sharp strictly between 0 and 100 (S 10-50),
+// BPM lags TAU behind: after a short crying wait it is stale, and crying at 100 then means it panicked
+static double reading_stress(const controller_state *s, const controller_input *in)
+{
+  if (in->cry > 0 && in->cry < 100)
+    return (in->cry + 25) / 2.5;
+  if (s->observe && s->is_crying_activated)
+    return (in->cry >= 100) ? s->levelS[0][9] / 2.0 : 10.0; // Spanic (same under every path), or K1
+  return (in->bpm - 60) / 1.8;
+}
+
+static double absd(double x)
+{
+  return (x < 0.0) ? -x : x;
+}
+
+// how well a plant that went from level L at S_old to level L2 explains the reading S_new under path h
+static double level_like(const controller_state *s, int h, int L, int L2, double S_old, double S_new)
+{
+  double drop = S_old - S_new;
+  if (L2 == L)
+    return (absd(drop) <= BELIEF_TOL) ? 1.0 : BELIEF_EPS;
+  if (s->levelS[h][L2]) // seen that level before
+    return (absd(S_new - s->levelS[h][L2] / 2.0) <= BELIEF_TOL) ? 1.0 : BELIEF_EPS;
+  if (L2 < L) // n unseen levels down: 7-11 each (1 up where the sim caps Sopt at 98)
+  {
+    int n = L - L2;
+    double lo = ((S_old > 97.5) ? n : 7 * n) - BELIEF_TOL, hi = 11 * n + BELIEF_TOL;
+    return (drop >= lo && drop <= hi) ? 1.0 : BELIEF_EPS;
+  }
+  return (drop < -BELIEF_TOL) ? 1.0 : BELIEF_EPS;
+}
+
+// Bayes update for the move prev -> cur that settled at S_new. Per path the plant ends on the cell's K,
+// or back at K9 if the move could panic (purely softer 2+ levels down, or purely harder)
+static void belief_observe(controller_state *s, unsigned char kt[CTRL_PATHS][25], int prev, int cur, double S_new)
+{
+  int softer = (cur / 5 < prev / 5) || (cur % 5 < prev % 5);
+  int harder = (cur / 5 > prev / 5) || (cur % 5 > prev % 5);
+  double total = 0.0;
+  for (int h = 0; h < CTRL_PATHS; h++)
+  {
+    int L = s->level[h], K = kt[h][cur];
+    double like = level_like(s, h, L, K, s->lastS, S_new);
+    int may_panic = (softer && !harder && K <= L - 2) || (harder && !softer && K > L);
+    if (may_panic && K != 9)
+    {
+      double like9 = level_like(s, h, L, 9, s->lastS, S_new);
+      s->level[h] = (unsigned char)((like9 > like) ? 9 : K);
+      like = 0.5 * like + 0.5 * like9;
+    }
+    else
+      s->level[h] = (unsigned char)K;
+    s->belief[h] *= like;
+    total += s->belief[h];
+  }
+
+  if (total <= 0.0) // nothing fits any more, start over
+  {
+    belief_reset(s);
+    return;
+  }
+  for (int h = 0; h < CTRL_PATHS; h++)
+    s->belief[h] /= total;
+}
+
+// read this step: judge the last move (if any) and remember the settled stress per path and level
+static double belief_sense(controller_state *s, unsigned char kt[CTRL_PATHS][25], const controller_input *in)
+{
+  double S_now = reading_stress(s, in);
+  if (s->observe)
+    belief_observe(s, kt, s->prevA * 5 + s->prevF, s->curA * 5 + s->curF, S_now);
+  s->observe = 0;
+
+  for (int h = 0; h < CTRL_PATHS; h++)
+    s->levelS[h][s->level[h]] = (unsigned char)(S_now * 2.0 + 0.5);
+  s->lastS = S_now;
+  s->lastBPM = in->bpm;
+  s->lastCRY = in->cry;
+  s->is_crying_activated = (in->cry > 0 && in->cry < 100);
+  return S_now;
+}
+
+// most likely path, logged with how many are still in the running
+static int belief_map(const controller_state *s, char tag)
+{
+  int map = 0, nl = 0;
+  for (int h = 0; h < CTRL_PATHS; h++)
+  {
+    if (s->belief[h] > s->belief[map])
+      map = h;
+    nl += s->belief[h] > BELIEF_EPS; // not contradicted by any reading so far
+  }
+  char ps[9];
+  for (int i = 0; i < 8; i++)
+    ps[i] = ((s->pathMask[map] >> i) & 1) ? 'U' : 'L';
+  ps[8] = '\0';
+  CTRL_LOG(s, "[%c] %d paths left, likeliest %s p=%.2f\n", tag, nl, ps, s->belief[map]);
+  return map;
+}
+
+// best single move from 'from' for the paths in live[] with weights w (need not sum to 1):
+// weight times expected steps to A1 F1 when that move is followed by the known path, 0 if already there
+static double plan_one(unsigned char kt[CTRL_PATHS][25], const double *w, const int *live, int nl, int from)
+{
+  double mass = 0.0, at_goal = 0.0;
+  for (int j = 0; j < nl; j++)
+  {
+    mass += w[live[j]];
+    if (kt[live[j]][from] == 1)
+      at_goal += w[live[j]];
+  }
+  if (mass <= 0.0 || at_goal >= mass)
+    return 0.0;
+
+  double best = -1.0;
+  for (int to = 24; to >= 0; to--)
+  {
+    if (to == from)
+      continue;
+    double risk = 0.0, steps = 0.0;
+    for (int j = 0; j < nl; j++)
+    {
+      int h = live[j];
+      if (kt[h][to] < kt[h][from] - 1)
+        risk += w[h];
+      steps += w[h] * kt[h][to]; // this move + K - 1 more
+    }
+    if (risk <= BELIEF_RISK * mass && (best < 0.0 || steps < best))
+      best = steps;
+  }
+  return (best < 0.0) ? 9.0 * mass : best;
+}
+
+// two-step lookahead: the move from cur whose reading (lower / same / higher) sets up the cheapest next move.
+// falls back to the least risky move if none is safe enough
+static int belief_plan(const controller_state *s, unsigned char kt[CTRL_PATHS][25], int cur)
+{
+  int live[CTRL_PATHS], nl = 0;
+  for (int h = 0; h < CTRL_PATHS; h++)
+    if (s->belief[h] > BELIEF_LIVE)
+      live[nl++] = h;
+
+  int best = -1, safest = -1;
+  double best_q = 0.0, safest_risk = 2.0;
+  for (int y = 24; y >= 0; y--) // high index first: LEFT before UP on ties, like the anchor search
+  {
+    if (y == cur)
+      continue;
+
+    double risk = 0.0;
+    double w[3][CTRL_PATHS];
+    int lv[3][CTRL_PATHS], n[3] = {0, 0, 0};
+    for (int j = 0; j < nl; j++)
+    {
+      int h = live[j];
+      int dk = kt[h][y] - s->level[h];
+      int o = (dk < 0) ? 0 : (dk == 0) ? 1 : 2; // what the reading will do: lower, same, higher
+      if (dk <= -2)
+        risk += s->belief[h];
+      w[o][h] = s->belief[h];
+      lv[o][n[o]++] = h;
+    }
+
+    if (risk < safest_risk)
+    {
+      safest_risk = risk;
+      safest = y;
+    }
+    if (risk > BELIEF_RISK)
+      continue;
+
+    double q = 1.0;
+    for (int o = 0; o < 3; o++)
+      q += plan_one(kt, w[o], lv[o], n[o], y);
+    if (best < 0 || q < best_q)
+    {
+      best_q = q;
+      best = y;
+    }
+  }
+  return (best >= 0) ? best : safest;
+}
+
+// One belief mode step: judge the last move on this reading, then command the next cell
+static void belief_step(controller_state *s, const controller_input *in, controller_output *out)
+{
+  unsigned char kt[CTRL_PATHS][25];
+  for (int h = 0; h < CTRL_PATHS; h++)
+    path_fill_k(s->pathMask[h], kt[h]);
+
+  int cur = s->curA * 5 + s->curF;
+  double S_prev = s->lastS;
+  int judged = s->observe;
+  double S_now = belief_sense(s, kt, in);
+  belief_map(s, 'B');
+
+  if (judged && S_now > S_prev + BELIEF_TOL)
+  {
+    // panicked (or a harder cell): A5 F5 is K9 with S at Spanic whatever happened, start over from there
+    CTRL_LOG(s, "[B] WORSE at A%d F%d -> back to A5 F5\n", s->curA + 1, s->curF + 1);
+    for (int h = 0; h < CTRL_PATHS; h++)
+      s->level[h] = 9;
+    command_cell(s, out, 4, 4);
+    return;
+  }
+
+  if (cur == 0)
+  {
+    CTRL_LOG(s, "[B] BABY CALM holding A1 F1\n");
+    return;
+  }
+
+  int next = belief_plan(s, kt, cur);
+  s->prevA = s->curA;
+  s->prevF = s->curF;
+  s->observe = 1;
+  CTRL_LOG(s, "[B] A%d F%d -> A%d F%d\n", s->curA + 1, s->curF + 1, next / 5 + 1, next % 5 + 1);
+  command_cell(s, out, next / 5, next % 5);
+}
+
+// MPC MODE
+// Model-predictive lookahead on top of the belief. Draw MPC_SAMPLES complete plants: a path from
+// the belief, Sopt as read at the levels seen so far, the other levels and every band drawn from the
+// generator's ranges. Fork each plant for every candidate move (LEFT, UP, diagonal, the reverse
+// diagonals, backtrack, next cell of the likeliest path) and roll it out: the candidate, then that
+// path one level per step until calm. Lowest mean time-to-calm wins, a panic is charged MPC_PANIC_MS
+// on top of the time it loses. A candidate that panics more than BELIEF_RISK of the plants is out, like
+// in belief mode: no time saved is worth panicking the baby on purpose. 64 samples x 7 candidates is
+// ~450 rollouts, well under a millisecond.
+
+#define MPC_SAMPLES 64
+#define MPC_HORIZON 12     // rollout steps after the candidate
+#ifndef MPC_PANIC_MS
+#define MPC_PANIC_MS 120000 // extra cost of a panic later in a rollout: the baby's distress is worse than lost time
+#endif
+#define MPC_CANDIDATES 7
+
+static unsigned mpc_rand(controller_state *s) // xorshift32
+{
+  unsigned x = s->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return s->rng = x;
+}
+
+// how long the controller waits after commanding a move from a plant settled at S
+static int mpc_wait_ms(double S)
+{
+  return ((S > 10.0 && S < 50.0) ? CRYING_DELAY : HEARTBEAT_DELAY) + SETTLE_MARGIN;
+}
+
+// one complete plant under path h, settled where the belief says it is. path_cell[k] = path cell at K k
+static void mpc_sample(controller_state *s, const unsigned char k[25], int h, int cur,
+                       plant_snapshot *p, unsigned char path_cell[10])
+{
+  memcpy(p->K, k, sizeof(p->K));
+
+  // Sopt: as read where seen. unseen levels 7-11 below the one above, or evenly between two seen ones
+  for (int lv = 9; lv >= 1; lv--)
+  {
+    if (s->levelS[h][lv] || lv == 9)
+    {
+      p->Sopt[lv] = s->levelS[h][lv] / 2.0f;
+      continue;
+    }
+    int j = lv - 1;
+    while (j >= 1 && !s->levelS[h][j])
+      j--;
+    if (j >= 1)
+      p->Sopt[lv] = p->Sopt[lv + 1] - (p->Sopt[lv + 1] - s->levelS[h][j] / 2.0f) / (lv + 1 - j);
+    else
+      p->Sopt[lv] = p->Sopt[lv + 1] - (float)(7 + mpc_rand(s) % 5);
+  }
+
+  // bands like generate_bands: 6-12 either side, and each one reaches the next level's Sopt
+  for (int lv = 1; lv <= 9; lv++)
+  {
+    float half = (float)(6 + mpc_rand(s) % 7);
+    p->lo[lv] = (p->Sopt[lv] - half < 0.0f) ? 0.0f : p->Sopt[lv] - half;
+    p->hi[lv] = (p->Sopt[lv] + half > 100.0f) ? 100.0f : p->Sopt[lv] + half;
+  }
+  for (int lv = 2; lv <= 9; lv++)
+  {
+    if (p->hi[lv - 1] < p->Sopt[lv])
+      p->hi[lv - 1] = (p->Sopt[lv] > 100.0f) ? 100.0f : p->Sopt[lv];
+    if (p->lo[lv - 1] > p->hi[lv - 1])
+      p->lo[lv - 1] = p->hi[lv - 1];
+  }
+
+  p->cell = (unsigned char)cur;
+  p->level = s->level[h];
+
+  int a = 4, f = 4, m = s->pathMask[h];
+  path_cell[9] = 24;
+  for (int i = 0; i < 8; i++)
+  {
+    if ((m >> i) & 1)
+      a--;
+    else
+      f--;
+    path_cell[8 - i] = (unsigned char)(a * 5 + f);
+  }
+}
+
+// time-to-calm in ms of one forked plant: command cand, then follow the path one level per step.
+// *panicked = 1 if cand itself panics this plant
+static double mpc_rollout(plant_snapshot p, const unsigned char path_cell[10], int cand, int *panicked)
+{
+  double ms = mpc_wait_ms(p.Sopt[p.level]);
+  int kind = plant_move(&p, cand);
+  *panicked = (kind == MOVE_PANIC_JUMP || kind == MOVE_PANIC_BLOCK);
+  if (*panicked)
+    ms += MPC_PANIC_MS;
+
+  for (int step = 0; step < MPC_HORIZON && !(p.cell == 0 && p.level == 1); step++)
+  {
+    ms += mpc_wait_ms(p.Sopt[p.level]);
+    kind = plant_move(&p, (p.level > 1) ? path_cell[p.level - 1] : 0);
+    if (kind == MOVE_PANIC_JUMP || kind == MOVE_PANIC_BLOCK)
+      ms += MPC_PANIC_MS;
+  }
+  if (!(p.cell == 0 && p.level == 1))
+    ms += (p.level - 1) * (double)(HEARTBEAT_DELAY + SETTLE_MARGIN);
+  return ms;
+}
+
+// One MPC mode step: judge the last move, then roll every candidate out on the same sampled plants
+static void mpc_step(controller_state *s, const controller_input *in, controller_output *out)
+{
+  unsigned char kt[CTRL_PATHS][25];
+  for (int h = 0; h < CTRL_PATHS; h++)
+    path_fill_k(s->pathMask[h], kt[h]);
+
+  int cur = s->curA * 5 + s->curF;
+  belief_sense(s, kt, in);
+  int map = belief_map(s, 'M');
+
+  if (cur == 0 && s->level[map] == 1)
+  {
+    CTRL_LOG(s, "[M] BABY CALM holding A1 F1\n");
+    return;
+  }
+
+  // candidates, LEFT first on ties like the anchor search
+  int a = s->curA, f = s->curF;
+  plant_snapshot map_plant;
+  unsigned char map_path[10];
+  mpc_sample(s, kt[map], map, cur, &map_plant, map_path);
+  int next_on_path = (s->level[map] > 1) ? map_path[s->level[map] - 1] : 0; // likeliest path, one level down
+  int raw[MPC_CANDIDATES][2] = {
+      {a, f - 1}, {a - 1, f}, {a - 1, f - 1}, {a - 1, f + 1}, {a + 1, f - 1},
+      {s->prevA, s->prevF}, {next_on_path / 5, next_on_path % 5}};
+  int cand[MPC_CANDIDATES], nc = 0;
+  for (int i = 0; i < MPC_CANDIDATES; i++)
+  {
+    int ca = raw[i][0], cf = raw[i][1], dup = 0;
+    if (ca < 0 || ca > 4 || cf < 0 || cf > 4 || ca * 5 + cf == cur)
+      continue;
+    for (int j = 0; j < nc; j++)
+      dup |= cand[j] == ca * 5 + cf;
+    if (!dup)
+      cand[nc++] = ca * 5 + cf;
+  }
+  if (nc == 0)
+    return;
+
+  // common random plants for every candidate
+  double cost[MPC_CANDIDATES] = {0};
+  int panics[MPC_CANDIDATES] = {0};
+  for (int i = 0; i < MPC_SAMPLES; i++)
+  {
+    double u = (mpc_rand(s) >> 8) / 16777216.0, acc = 0.0;
+    int h = 0;
+    for (; h < CTRL_PATHS - 1; h++)
+    {
+      acc += s->belief[h];
+      if (u < acc)
+        break;
+    }
+
+    plant_snapshot snap;
+    unsigned char path_cell[10];
+    mpc_sample(s, kt[h], h, cur, &snap, path_cell);
+    for (int j = 0; j < nc; j++)
+    {
+      int panicked;
+      cost[j] += mpc_rollout(snap, path_cell, cand[j], &panicked);
+      panics[j] += panicked;
+    }
+  }
+
+  // like belief mode, no move that panics more than BELIEF_RISK of the plants. the least risky if none is safe
+  int best = -1, safest = 0;
+  for (int j = 0; j < nc; j++)
+  {
+    if (panics[j] < panics[safest])
+      safest = j;
+    if (panics[j] <= BELIEF_RISK * MPC_SAMPLES && (best < 0 || cost[j] < cost[best]))
+      best = j;
+  }
+  if (best < 0)
+    best = safest;
+
+  int next = cand[best];
+  s->prevA = s->curA;
+  s->prevF = s->curF;
+  s->observe = 1;
+  CTRL_LOG(s, "[M] A%d F%d -> A%d F%d (%.1f s to calm expected, %d rollouts)\n", s->curA + 1, s->curF + 1,
+           next / 5 + 1, next % 5 + 1, cost[best] / MPC_SAMPLES / 1000.0, MPC_SAMPLES * nc);
+  command_cell(s, out, next / 5, next % 5);
+}
+
+// TABLE MODE
+// The whole decision is one load from a POLICY_STATES table. The state is what the anchor search
+// looks at anyway: the anchor cell, which probe of it we are on, whether the last reading went down,
+// stayed or went up, and which probes were tried. A lower reading makes the current cell the anchor.
+// policy_table.h is generated by ../sim/sim -G, which improves policy_default on simulated babies,
+// so the cradle makes exactly the decisions the benchmark measured.
+
+#if POLICY_TABLE_STATES != POLICY_STATES
+#error "policy_table.h was generated for another state layout, regenerate it with ../sim/sim -G"
+#endif
+
+unsigned char policy_default(int index)
+{
+  int tried = index % 4;
+  int trend = (index / 4) % 3;
+  int probe = (index / 12) % 4;
+  int cell = index / 48;
+  int a = cell / 5, f = cell % 5;
+
+  if (probe == 0) // on the anchor: LEFT, then UP, then both at once
+  {
+    if (!(tried & 1) && f > 0)
+      return POLICY_LEFT;
+    if (!(tried & 2) && a > 0)
+      return POLICY_UP;
+    if (a > 0 && f > 0)
+      return POLICY_DIAG;
+    return (f > 0) ? POLICY_LEFT : (a > 0) ? POLICY_UP : POLICY_HOLD;
+  }
+  if (trend == 2) // worse: back to the anchor
+    return POLICY_BACK;
+  if (probe == 1 && a > 0) // same after LEFT: the path goes UP (reverse diagonal)
+    return POLICY_UP;
+  if (probe == 2 && !(tried & 1) && f > 0)
+    return POLICY_LEFT;
+  return POLICY_BACK;
+}
+
+static void table_step(controller_state *s, const controller_input *in, controller_output *out)
+{
+  double S_now;
+  int trend = 1;
+  if (s->observe && s->is_crying_activated && in->cry >= 100)
+  {
+    trend = 2; // cried out of the crying regime: worse, at a level the stale BPM cannot tell yet
+    S_now = -1.0;
+  }
+  else
+  {
+    S_now = reading_stress(s, in);
+    if (s->observe && s->lastS >= 0.0)
+      trend = (S_now < s->lastS - BELIEF_TOL) ? 0 : (S_now > s->lastS + BELIEF_TOL) ? 2 : 1;
+  }
+  s->observe = 0;
+  s->lastS = S_now;
+  s->lastBPM = in->bpm;
+  s->lastCRY = in->cry;
+  s->is_crying_activated = (in->cry > 0 && in->cry < 100);
+  s->policyState = -1;
+
+  if (s->panic_mode) // warm start: the anchors first, and no trend from the stress the walk began at
+  {
+    recover_step(s, out);
+    s->lastS = -1.0;
+    return;
+  }
+
+  if (s->anchorA_mem < 0 || (trend == 0 && s->lastMoveDir != 0)) // start, or improved: new anchor
+  {
+    s->anchorA_mem = s->curA;
+    s->anchorF_mem = s->curF;
+    s->lastMoveDir = 0;
+    s->triedLeftFromAnchor = 0;
+    s->triedUpFromAnchor = 0;
+    register_anchor(s, s->curA, s->curF);
+  }
+
+  if (s->curA == 0 && s->curF == 0)
+  {
+    CTRL_LOG(s, "[T] BABY CALM holding A1 F1\n");
+    return;
+  }
+
+  int aa = s->anchorA_mem, af = s->anchorF_mem;
+  int tried = (s->triedLeftFromAnchor ? 1 : 0) | (s->triedUpFromAnchor ? 2 : 0);
+  s->policyState = POLICY_INDEX(aa * 5 + af, s->lastMoveDir, trend, tried);
+  int act = (s->policy ? s->policy : policy_table)[s->policyState];
+
+  int ta = aa, tf = af, probe = 0;
+  if (act == POLICY_LEFT)
+  {
+    tf--;
+    probe = 1;
+    s->triedLeftFromAnchor = 1;
+  }
+  else if (act == POLICY_UP)
+  {
+    ta--;
+    probe = 2;
+    s->triedUpFromAnchor = 1;
+  }
+  else if (act == POLICY_DIAG)
+  {
+    ta--;
+    tf--;
+    probe = 3;
+  }
+
+  CTRL_LOG(s, "[T] state %d (anchor A%d F%d probe %d trend %d tried %d) -> action %d\n",
+           s->policyState, aa + 1, af + 1, s->lastMoveDir, trend, tried, act);
+  if (act == POLICY_HOLD || ta < 0 || tf < 0 || (ta == s->curA && tf == s->curF))
+    return;
+
+  s->lastMoveDir = probe;
+  s->prevA = s->curA;
+  s->prevF = s->curF;
+  s->observe = 1;
+  command_cell(s, out, ta, tf);
+}
+
+// One controller step for
+// This function is called every control cycle with the latest BPM and CRY and decides what to command on the motor grid.
+// Yes this is extensively documented so that everyone can understand. Yes including me.
+// bpm_now is the current heartbeat in BPM, cry_now is the current crying level (%) both are measured by the submodules, hopefully.
+void controller_step(controller_state *s, const controller_input *in, controller_output *out)
+{
+  int bpm_now = in->bpm;
+  int cry_now = in->cry;
+
+  out->move = 0;
+  s->sinceStep = 0;
+  s->settleMove = 0;
+  s->watchFired = 0;
+  s->stepCry = in->cry;
+  tau_update(s);
+  if (s->mode == CTRL_MODE_BELIEF)
+  {
+    belief_step(s, in, out);
+    return;
+  }
+  if (s->mode == CTRL_MODE_MPC)
+  {
+    mpc_step(s, in, out);
+    return;
+  }
+  if (s->mode == CTRL_MODE_TABLE)
+  {
+    table_step(s, in, out);
+    return;
+  }
+  s->hit_wall = 0; // Detector flag for (AxF1 or A1Fx so we can be smart and reduce the delay to just the convergence time)
+
+  // PANIC DETECTION USING VITALS
+  // In this part we look only at BPM and CRY and decide whether the baby is in a panic state and we must enter panic_mode.
+  // This matters because if we are in panic mode we need to go to K9 to start again. Currently the motors stop for testing purposes
+
+  int big_jump = 0; // This variable will be set to 1 if the BPM suddenly jumps up a lot compared to the previous BPM
+
+  if (s->lastBPM > 0)                        // We only check for a BPM jump if we have a valid previous BPM
+    big_jump = (bpm_now - s->lastBPM >= 30); // Here we compute the difference between current BPM and last BPM, and set big_jump to 1 if the increase is 30 BPM or more.
+
+  if (!s->panic_mode) // We only re-check panic conditions if we are not already in panic mode; once in panic, we stay there until recover_step has replayed the anchors.
+  {
+    if (big_jump) // If any of our panic flags are true, panic.
+    {
+      s->panic_mode = 1; // We now enter panic mode, meaning that the rest of this function will follow the panic-mode path instead of the normal algorithm.
+      s->replayLevel = 10; // and recover by walking the anchors from the first one
+      if (s->lastMoveDir != 0 && (s->prevA != s->curA || s->prevF != s->curF))
+        mark_bad(s, s->curA, s->curF); // the probe we are on did it (the watchdog has not backed it out)
+
+      CTRL_LOG(s, "[A] PANIC(BPM=%d, CRY=%d)\n", bpm_now, cry_now); // We log a message so we can see exactly when and with what values the panic was triggered.
+    }
+  }
+
+  // PANIC MODE: REPLAY THE ANCHORS
+  // When panic_mode is active, we stop exploring the (A, F) grid and walk back down the anchors we already know (recover_step).
+
+  if (s->panic_mode)
+  {
+    recover_step(s, out);
+
+    s->lastBPM = bpm_now; // We still update lastBPM to the current BPM so history and logs remain up to date even during panic.
+    s->lastCRY = cry_now; // We also update lastCRY to the current crying level for the same reason.
+    return;                 // We leave the function early because, in panic mode, we do not want to run the normal inverse-model algorithm anymore.
+  }
+
+  // NORMAL MODE: CHECK WHETHER THE LAST MOVE HELPED OR NOT
+  // Since we are not in panic, we now look at whether the last motor command improved the baby’s state.
+
+  int improved = 0; // This will be set to 1 if the helper functions say that the situation actually got better after the last move.
+  int same = 0;     // This will be set to 1 if the situation is considered stable
+
+  if (bpm_now < 150 && (cry_now < 52 && cry_now > 15)) // If the current BPM is below 150, we stop using heart rate as its delayed and focus more on crying as an indicator of stress.
+  {
+    s->is_crying_activated = 1;             // We record that in this regime we are using crying as the primary signal to measure improvement.
+    improved = crying_improved(s, cry_now); // We call crying_improved with the current CRY value. returns 1 if crying suggests improvement.
+  }
+  else // If BPM is 150 or higher, the heart rate is used since crying is always %100 here
+  {
+    s->is_crying_activated = 0;                // We record that, in this regime, we are using BPM as the primary indicator of improvement.
+    improved = heartbeat_improved(s, bpm_now); // We call heartbeat_improved with the current BPM value. returns 1 if BPM suggests improvement
+  }
+
+  if (s->lastBPM > 0) // We  attempt a “stability” check (if we have a valid previous BPM value otherwise we cannot compare)
+  {
+    int bpm_delta = abs(bpm_now - s->lastBPM);                           // We calculate the absolute value of the difference between current BPM and last BPM to see how much it changed.
+    int cry_delta = (s->lastCRY >= 0) ? abs(cry_now - s->lastCRY) : 0; // For CRY, we do a similar absolute difference if we have a valid previous value; otherwise we treat it as zero change.
+
+    if (!s->is_crying_activated) // If we are currently in BPM-driven mode (using BPM to decide improvement),
+    {
+      if (bpm_delta <= 3) // then we consider the state “stable” if BPM changed by at most 3 beats since the last step.
+      {
+        CTRL_LOG(s, "[A] HB stable Del(BPM)=%d\n", bpm_delta);
+        if (s->lastMoveDir == 1) // If the last move we made on the grid was a LEFT move (direction 1),
+          same = 1;           // we set same to 1, meaning we have a “stable after LEFT” pattern that we will react to with a special move i call reverse diagonal later.
+      }
+    }
+    else // If we are in crying-driven mode (using CRY to decide improvement),
+    {
+      if (cry_delta == 0) // we treat the situation as stable only if crying did not change at all (difference equals zero).
+      {
+        CTRL_LOG(s, "[A] CRY stable ΔCRY=%d\n", cry_delta); // We log that the crying level is stable and show the CRY difference (which is zero here).
+        if (s->lastMoveDir == 1)                              // Again, this only matters if the last move direction was LEFT,
+          same = 1;                                        // so we set same to 1 in that case to remember the “stable after LEFT” condition.
+      }
+    }
+  }
+
+  // ANCHOR SYNC WHEN IDLE (lastMoveDir == 0)
+  // Anchors are positions on the grid that we know are in the solution path
+  // when idle we make sure our stored anchor matches our current position.
+
+  if (s->lastMoveDir == 0) // If lastMoveDir is 0, it means we are not in the middle of a move and are sitting on some anchor position.
+  {
+    if (s->anchorA_mem != s->curA || s->anchorF_mem != s->curF) // If the anchor stored in memory does not match our current (curA, curF) on the grid,
+    {
+      s->anchorA_mem = s->curA;      // we update the stored anchor amplitude index to the current A index.
+      s->anchorF_mem = s->curF;      // we also update the stored anchor frequency index to the current F index.
+      s->triedLeftFromAnchor = 0; // We reset the flag indicating whether we have tried going LEFT from this anchor, so it becomes allowed again.
+      s->triedUpFromAnchor = 0;   // We also reset the flag indicating whether we have tried going UP from this anchor.
+
+      register_anchor(s, s->anchorA_mem, s->anchorF_mem); // We call register_anchor to tell the rest of the system that (curA, curF) is now our chosen anchor cell.
+      // this will later be used to follow a predetermined path to solution if a panic jump is caused to save time
+    }
+  }
+
+  // FIRST MOVE FROM AN ANCHOR (when lastMoveDir == 0)
+  // From an anchor, the algorithm chooses which neighbour to explore first (LEFT or UP).
+
+  if (s->lastMoveDir == 0) // We are in the idle state, so now we decide the first exploration step from this anchor.
+  {
+    s->prevA = s->curA; // We store the current amplitude index as prevA, so we can return here later if needed.
+    s->prevF = s->curF; // We also store the current frequency index as prevF for the same reason.
+    if (is_bad(s, s->curA, s->curF - 1)) // a probe that panicked before counts as tried
+      s->triedLeftFromAnchor = 1;
+    if (is_bad(s, s->curA - 1, s->curF))
+      s->triedUpFromAnchor = 1;
+    if (!s->triedLeftFromAnchor && s->curF == 0)
+    {
+      s->hit_wall = 1; // wanted to try LEFT but wall
+      command_cell(s, out, s->curA - 1, s->curF);
+      CTRL_LOG(s, "[A] Hit left wall\n");
+    }
+    else if (!s->triedUpFromAnchor && s->curA == 0)
+    {
+      s->hit_wall = 1; // wanted to try UP but wall
+      command_cell(s, out, s->curA, s->curF - 1);
+      CTRL_LOG(s, "[A] Hit upper wall\n");
+    }
+    // just to be sure we still check vitals after we hit a wall instead of just going down.
+
+    else if (!s->triedLeftFromAnchor && s->curF > 0) // If we have not already tried going LEFT from this anchor and we are not at the left border of the grid (F > 0),
+    {
+      s->lastMoveDir = 1;         // We set lastMoveDir to 1 to remember that we are now making a LEFT move.
+      s->triedLeftFromAnchor = 1; // We also mark that from this anchor, LEFT has now been attempted, so we do not retry it immediately later.
+
+      CTRL_LOG(s, "[A] TRY-> LEFT from A%d F%d\n", s->curA + 1, s->curF + 1);
+
+      command_cell(s, out, s->curA, s->curF - 1); // We send the actual motor command to move to the cell with the same A index and F index decreased by one (one step LEFT on the grid).
+
+      s->lastBPM = bpm_now; // After issuing the command, we record the current BPM so that next time we can compare and see if there was improvement.
+      s->lastCRY = cry_now; // We also record the current CRY for the same comparison on the next step.
+      return;                 // We return immediately, because we want to wait and see how this LEFT move changes the baby’s vitals before doing anything else.
+    }
+    else if (!s->triedUpFromAnchor && s->curA > 0) // If LEFT is not available or already tried, but we have not tried UP and we are not at the top row (A > 0),
+    {
+      s->lastMoveDir = 2;       // We set lastMoveDir to 2 to indicate that our next move is an UP move.
+      s->triedUpFromAnchor = 1; // We mark that from this anchor, UP has been attempted, to avoid repeating it unnecessarily.
+
+      CTRL_LOG(s, "[A] Blocked-> UP from A%d F%d\n", s->curA + 1, s->curF + 1); // We log that our TRY move from this anchor is UP, and note that LEFT was already tried or blocked.
+
+      command_cell(s, out, s->curA - 1, s->curF); // We send the motor command to move to the neighbour above, which has A index decreased by one and the same F index.
+
+      s->lastBPM = bpm_now; // We store the BPM we saw before this UP move so that we can check later if it improved things.
+      s->lastCRY = cry_now; // We also store the CRY level for the same reason.
+      return;                 // We return here, again to wait for the effect of this UP move on the vitals.
+    }
+    else if (s->curA + 1 == 1 && s->curF + 1 == 1) // If neither LEFT nor UP is available (or both have already been tried from this anchor),
+    {
+      CTRL_LOG(s, "[A] BABY CALM holding A%d F%d\n", s->curA + 1, s->curF + 1);
+
+      s->lastBPM = bpm_now; // Even though we are not moving, we still update the last BPM value to what we just measured.
+      s->lastCRY = cry_now; // And we also update the last CRY value.
+      return;                 // We exit the function while staying at this anchor, just monitoring the baby’s state.
+    }
+    else if (back_from_dead_end(s, out)) // both tried from here: the anchor before this one may have another way
+    {
+      s->lastBPM = bpm_now;
+      s->lastCRY = cry_now;
+      return;
+    }
+    else // If neither LEFT nor UP is available (or both have already been tried from this anchor),
+    {
+      CTRL_LOG(s, "[A] Fatal Error! holding A%d F%d\n", s->curA + 1, s->curF + 1);
+
+      s->lastBPM = bpm_now; // Even though we are not moving, we still update the last BPM value to what we just measured.
+      s->lastCRY = cry_now; // And we also update the last CRY value.
+      return;                 // We exit the function while staying at this anchor, just monitoring the baby’s state.
+    }
+  }
+
+  // WE HAVE A LAST MOVE (lastMoveDir != 0) // If we reach here, it means we are returning after having commanded a move in the previous step.
+
+  if (improved) // If the helper functions said that the last move improved the situation,
+  {
+    int anchorA = s->curA; // We now treat the current A index (where we ended up) as a new anchor amplitude index.
+    int anchorF = s->curF; // We also treat the current F index as a new anchor frequency index.
+
+    CTRL_LOG(s, "[A] IMPROVED -> anchor A%d F%d\n", anchorA + 1, anchorF + 1);
+
+    register_anchor(s, anchorA, anchorF); // We tell the anchor-management logic that this cell (anchorA, anchorF) should be added or updated as an anchor on the path.
+
+    if (s->anchorA_mem != anchorA || s->anchorF_mem != anchorF) // If our remembered anchor position does not yet match this new anchor,
+    {
+      s->anchorA_mem = anchorA;   // we store the new anchor amplitude index in anchorA_mem.
+      s->anchorF_mem = anchorF;   // and the new anchor frequency index in anchorF_mem.
+      s->triedLeftFromAnchor = 0; // We reset the “tried left” flag, because this is a fresh anchor and we can try LEFT from it again.
+      s->triedUpFromAnchor = 0;   // We also reset the “tried up” flag for the same reason.
+    }
+
+    s->prevA = anchorA; // We also store this anchor as prevA so that, if future moves fail, we can backtrack to it.
+    s->prevF = anchorF; // And we store it as prevF for backtracking in frequency.
+
+    if (anchorF > 0) // If we are not at the left border, we can try going further LEFT from this new anchor.
+    {
+      s->lastMoveDir = 1;         // We set the last move direction to LEFT again, as we are planning a follow-up LEFT move.
+      s->triedLeftFromAnchor = 1; // We mark that LEFT has been tried from this anchor so we do not keep repeating it forever.
+
+      CTRL_LOG(s, "[A] IMPROVED-> LEFT from A%d F%d\n", anchorA + 1, anchorF + 1); // We log that, because the last move was good, we are going to continue exploring by moving LEFT from this new anchor.
+
+      command_cell(s, out, anchorA, anchorF - 1); // We command the motor module to move to the cell one step LEFT of the current anchor position.
+      // we can shorten delays if borders are hit since there is only going to remain one path to solution so we wouldnt need to wait for the whole heartbeat delay and just the convergence delay. I just dont think this will happen.
+    }
+    else if (anchorA > 0) // Otherwise, if LEFT is impossible but we can still move UP (not at top boundary),
+    {
+      s->lastMoveDir = 2; // We set the next move direction to UP.
+      // Note: we do not mark triedUpFromAnchor here, but we could if we want symmetric behaviour.
+
+      CTRL_LOG(s, "[A] IMPROVED-> try UP from A%d F%d\n", anchorA + 1, anchorF + 1); // We log that we improved and now we will try moving UP from this anchor instead.
+
+      command_cell(s, out, anchorA - 1, anchorF); // We command a move to the cell directly above this anchor (one step lower in A index).
+    }
+
+    s->lastBPM = bpm_now; // After planning the next move, we store the current BPM so we can judge the effect in the next step.
+    s->lastCRY = cry_now; // And we also store the current crying level for the same purpose.
+    return;                 // We exit here since the next decision will be made after we see new vitals.
+  }
+  else // If improved is 0, it means the last move did not make things better (it might be the same or worse).
+  {
+    // HANDLE NO-IMPROVEMENT (SAME OR WORSE) // We now decide whether to try a special reverse-diagonal move or just backtrack.
+
+    if (same && s->lastMoveDir == 1) // If the state is considered “stable” and the last move direction was LEFT (dir=1),
+    {
+      int anchorA = s->prevA; // we use prevA as the anchor A index from which we came before that LEFT move.
+      int anchorF = s->prevF; // and prevF as the anchor F index from before that LEFT move.
+
+      if (anchorA > 0 && !is_bad(s, anchorA - 1, anchorF)) // If we can still move UP from that previous anchor (i.e., we are not at the top row) and that did not panic before,
+      {
+        CTRL_LOG(s, "[A] SAME-> R.D from A%d F%d\n", anchorA + 1, anchorF + 1); // We log that we detected the “same after left” pattern and will now try a reverse diagonal step from that anchor.
+
+        s->lastMoveDir = 2;       // We set lastMoveDir to 2 because the reverse diagonal involves an UP move from the previous anchor.
+        s->triedUpFromAnchor = 1; // We mark that, from this anchor, we are now trying UP so we do not keep repeating it unnecessarily.
+
+        s->prevA = s->curA; // We store the current A index as prevA so that if this reverse diagonal is bad, we can backtrack back here.
+        s->prevF = s->curF; // We also store the current F index as prevF for symmetrical backtracking.
+
+        command_cell(s, out, anchorA - 1, anchorF); // We execute the reverse diagonal by commanding the cell that is one step UP from the previous anchor.
+
+        s->lastBPM = bpm_now; // We update ctrl_lastBPM to remember the BPM at the moment we made this reverse diagonal decision.
+        s->lastCRY = cry_now; // And we also update ctrl_lastCRY to remember the CRY level at this moment.
+        return;                 // We return so that on the next call we can see if this reverse diagonal move improved things.
+      }
+    }
+
+    int anchorA = s->prevA; // If the special case above does not apply or is impossible, we prepare to backtrack to the previous anchor’s A index.
+    int anchorF = s->prevF; // And we prepare to backtrack to the previous anchor’s F index.
+
+    if (anchorA != s->curA || anchorF != s->curF) // If we are not already at that previous anchor cell,
+    {
+      CTRL_LOG(s, "[A] NO IMPROVEMENT -> A%d F%d\n", anchorA + 1, anchorF + 1); // We log that there was no improvement and that we are backtracking to that anchor, including the direction we came from.
+
+      command_cell(s, out, anchorA, anchorF); // We send the command to move the motor state back exactly to the previous anchor cell on the grid.
+    }
+
+    s->curA = anchorA; // We update our current amplitude index to the anchor amplitude index we backtracked to.
+    s->curF = anchorF; // We update our current frequency index to the anchor frequency index we backtracked to.
+
+    s->lastMoveDir = 0; // We reset lastMoveDir to 0, indicating that we are now idle at an anchor and ready for the next “first move” decision.
+
+    s->lastBPM = bpm_now; // We store the current BPM as the last BPM for the next control step comparison.
+    s->lastCRY = cry_now; // We store the current crying level as the last CRY for the next comparison as well.
+    return;                 // We exit the function; the next call will start again from an anchor in idle state.
+  }
+}
+
+int controller_period_ms(const controller_state *s)
+{
+  if (s->mode != CTRL_MODE_ANCHOR) // judge every move on the settled cell
+    return (s->is_crying_activated ? CRYING_DELAY : heartbeat_delay_ms(s)) + SETTLE_MARGIN;
+  if (s->hit_wall)
+    return CONVERGENCE_DELAY; // only one way left, just wait for convergence
+  if (s->is_crying_activated)
+    return CRYING_DELAY;
+  return heartbeat_delay_ms(s); // respect TAU
+}
@@ -0,0 +1,196 @@
+// controller.h — decision logic of the master, without any hardware.
+// The PYNQ master (main.c) and the PC simulator (../sim) both run this exact code:
+// feed it the latest vitals, it tells you which cell to command and how long to wait.
+
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+// real-world reaction delays to match the simulator
+#define HEARTBEAT_DELAY 14000 // ~10 s heartbeat delay (TAU)
+#define CRYING_DELAY 4000     // ~2 s crying / stress delay
+#define CONVERGENCE_DELAY 4000
+#define SETTLE_MARGIN 1000 // belief mode reads this long after the cell should have settled, not on the edge
+
+// TAU estimate: the vitals are sampled every TAU_SAMPLE_MS (controller_sample) and the lag that lines
+// the BPM series up best with the crying series, which has no delay, is TAU. Until there is one,
+// HEARTBEAT_DELAY stands.
+#define TAU_SAMPLE_MS 250
+#define TAU_MIN_MS 1000
+#define TAU_MAX_MS 20000
+#define TAU_MARGIN_MS 500 // on top of the estimate, which is only good to a sample or so
+#define TAU_HIST 160      // samples kept: the longest lag plus a window as long
+
+// settle detector: after a move, controller_settled says when the signal the next step reads (crying,
+// or BPM TAU later) has stopped moving, so the master can step before controller_period_ms, which
+// stays the upper bound
+#define SETTLE_WINDOW_MS 500 // flat for this long
+#define SETTLE_SLOPE 1.0     // flat: least-squares slope under this, in stress per second
+#ifndef SETTLE_MIN_MS
+#define SETTLE_MIN_MS CONVERGENCE_DELAY // the plant can still jump until this long after a move
+#endif
+
+// mid-step watchdog: a move clearly hurt if crying rose this much (%) right after it
+#define WATCH_CRY 20
+
+// controller modes (controller_state.mode)
+#define CTRL_MODE_ANCHOR 0 // LEFT-then-UP anchor search (default)
+#define CTRL_MODE_BELIEF 1 // Bayesian belief over every possible K path, see controller.c
+#define CTRL_MODE_MPC 2    // belief + rollouts of each candidate move on sampled plants (plant.h)
+#define CTRL_MODE_TABLE 3  // one lookup in policy_table.h, generated offline by ../sim/sim -G
+
+#define CTRL_PATHS 70 // monotone K9 -> K1 paths: 8 moves, 4 LEFT + 4 UP
+
+// table mode: the observable state is the anchor cell, where we are relative to it (0 = on it,
+// 1 = LEFT of it, 2 = above it, 3 = diagonal), the trend of the last reading (0 = lower, 1 = same,
+// 2 = higher) and which of LEFT (1) / UP (2) were tried from the anchor
+#define POLICY_STATES (25 * 4 * 3 * 4)
+#define POLICY_INDEX(cell, probe, trend, tried) ((((cell) * 4 + (probe)) * 3 + (trend)) * 4 + (tried))
+
+// table mode actions, all relative to the anchor
+#define POLICY_HOLD 0
+#define POLICY_LEFT 1
+#define POLICY_UP 2
+#define POLICY_DIAG 3
+#define POLICY_BACK 4 // back onto the anchor
+#define POLICY_ACTIONS 5
+
+// optional log sink (printf style), NULL = silent
+typedef void (*controller_log_fn)(const char *fmt, ...);
+
+// Controller state. One per cradle (or per simulated baby), nothing global.
+typedef struct controller_state
+{
+  // A/F grid (0-4). Start at A5 F5
+  int curA;
+  int curF;
+
+  int is_crying_activated;
+  int lastBPM;
+  int lastCRY;
+  int thresholdBPM;
+  int thresholdCRY;
+
+  int prevA;
+  int prevF;
+
+  int anchorA_mem, anchorF_mem;
+  int triedLeftFromAnchor;
+  int triedUpFromAnchor;
+
+  // 0 = none/initial, 1 = LEFT, 2 = UP
+  int lastMoveDir;
+
+  int hit_wall; // 1 if we attempted a direction but boundary blocked this cycle
+
+  // anchor map discovered so far (0 = unknown)
+  int anchorMatrix[5][5];
+  int anchorLevel;
+
+  int panic_mode;
+  int replayLevel; // panic recovery: anchorMatrix value walked to last (10 = not started)
+  int badCells;    // cells a probe panicked into (bit a * 5 + f): never probed again
+
+  int mode; // CTRL_MODE_*
+
+  // belief / MPC mode: probability of every K path, and whether the reading due now judges a move from (prevA, prevF)
+  double belief[CTRL_PATHS];
+  unsigned char pathMask[CTRL_PATHS];
+  int observe;
+  // per path: the K level S sits at (the cell's K once settled, 9 after a panic) and the settled
+  // stress read at each level so far (2 x S, 0 = not seen yet)
+  unsigned char level[CTRL_PATHS];
+  unsigned char levelS[CTRL_PATHS][10];
+  double lastS; // settled stress behind the last reading
+  unsigned rng; // MPC mode: draws the sampled plants, fixed seed so runs replay
+
+  // table mode: the table in use (NULL = the compiled-in policy_table) and the state looked up last step
+  // (-1 = none). The anchor is anchorA_mem / anchorF_mem, the probe lastMoveDir, the tried flags the triedXFromAnchor
+  const unsigned char *policy;
+  int policyState;
+
+  // TAU estimate: ring of the last TAU_HIST samples (oldest at tauHead), time of the newest, and the
+  // estimate in ms (0 = none yet)
+  unsigned char tauBpm[TAU_HIST];
+  unsigned char tauCry[TAU_HIST];
+  int tauHead, tauN;
+  unsigned tauLastMs;
+  int tauMs;
+
+  // settle detector: samples taken since the last step, and whether that step moved the cradle
+  int sinceStep;
+  int settleMove;
+
+  // watchdog: crying the last step ran on, whether its move was harder on either axis, and whether
+  // the watchdog already fired since (1 = reacted itself, 2 = asked for a step)
+  int stepCry;
+  int moveHarder;
+  int watchFired;
+
+  controller_log_fn log;
+} controller_state;
+
+// What a restart needs to pick up where the controller left off: the anchors, in the order they were
+// found, and the TAU estimate. Plain bytes, fixed size: main.c keeps it in a file. No time stamp: the
+// PYNQ has no clock that survives a power cycle, so whether it is still the same baby is the user's call.
+#define CTRL_SNAPSHOT_MAGIC 0x32425952u // "RYB2", change it with the layout
+typedef struct controller_snapshot
+{
+  unsigned magic;
+  unsigned short tauMs;
+  unsigned char mode;
+  unsigned char anchorLevel;
+  signed char anchorMatrix[25]; // index a * 5 + f
+  unsigned char check;          // sum of the bytes before it
+} controller_snapshot;
+
+// what the sensors said this cycle
+typedef struct controller_input
+{
+  int bpm; // heartbeat in BPM
+  int cry; // crying level in %
+} controller_input;
+
+// what to do about it
+typedef struct controller_output
+{
+  int move; // 1 if a cell was commanded this step
+  int a, f; // commanded cell (0-4), valid when move
+} controller_output;
+
+// fresh controller at A5 F5, default thresholds, no anchors, not panicking, anchor mode
+// (set s->mode afterwards to switch; the belief starts from the path generator's prior either way)
+void controller_init(controller_state *s);
+
+// One controller step: called every control cycle with the latest BPM and CRY.
+void controller_step(controller_state *s, const controller_input *in, controller_output *out);
+
+// feed the vitals between steps, at least every TAU_SAMPLE_MS (t_ms: any monotonic ms clock)
+void controller_sample(controller_state *s, unsigned t_ms, int bpm, int cry);
+
+// 1 once the response to the last step's move has settled (needs controller_sample), 0 if it has
+// not or there was no move: then wait out controller_period_ms
+int controller_settled(const controller_state *s);
+
+// mid-step watchdog, call after every controller_sample between steps. If the last move clearly hurt,
+// anchor mode backtracks to prevA / prevF right away (out->move = 1, command it like a step's move and
+// restart the step's clock: the next step waits for the back-out to settle);
+// the other modes judge moves on settled readings and a panic is settled at once, so they return 1:
+// step now instead of waiting for the period
+int controller_watchdog(controller_state *s, controller_output *out);
+
+// hand-written table mode policy (the anchor search's moves), what ../sim/sim -G starts improving from
+unsigned char policy_default(int index);
+
+// snapshot of s. Same state, same bytes: compare them to see whether anything changed
+void controller_save(const controller_state *s, controller_snapshot *snap);
+
+// warm start, right after controller_init and setting s->mode. Anchor and table modes replay the saved
+// anchors from A5 F5 like after a panic (the baby may have been left anywhere) and search on from
+// the last one; belief and MPC modes only take the TAU estimate, their belief assumes a K9 start.
+// 0 = restored, -1 = not a valid snapshot for this mode (s untouched)
+int controller_restore(controller_state *s, const controller_snapshot *snap);
+
+// how long to wait before the next step, in ms (depends on the regime the last step ended in)
+int controller_period_ms(const controller_state *s);
+
+#endif
@@ -11,6 +11,9 @@
 #include <stdio.h>
 #include <stdarg.h> // for log_printf
 #include <unistd.h>
+#include <pthread.h>
+
+#include "controller.h"
 
 #define UART_CH UART0
 #define MSTR 0
@@ -21,12 +24,9 @@
 #define TIMEOUT 20 // in ms
 #define MAX_PAY 5  // max payload length
 
-// *** NEW: real-world reaction delays to match the simulator ***
-#define HEARTBEAT_DELAY 14000 // ~10 s heartbeat delay (TAU)
-#define CRYING_DELAY 4000     // ~2 s crying / stress delay
-#define CONVERGENCE_DELAY 4000
+// real-world reaction delays (HEARTBEAT_DELAY, CRYING_DELAY, CONVERGENCE_DELAY) live in controller.h
 
-#define VITALS_POLL_MS 100 // request HB/CRY every 100ms
+#define VITALS_POLL_MS 1000 // keep-alive: HB/CRY nodes push at least this often once subscribed, changes at once
 
 // global variables for submodules (live readings)
 static uint8_t last_bpm = 0;
@@ -179,24 +179,35 @@ static void log_printf(const char *fmt, ...)
 
 // UART helpers
 
-// timeouted read of a single byte
-static int timeouted_byte(int ms)
+// everything the RX FIFO holds right now, up to max bytes: never waits
+static int uart_read_burst(uint8_t buf[], int max)
 {
-  int waited = 0;
-  while (waited < ms)
-  {
-    if (uart_has_data(UART_CH))
-      return (int)uart_recv(UART_CH);
-    sleep_msec(1);
-    waited += 1;
-  }
-  return -1;
+  int n = 0;
+  while (n < max && uart_has_data(UART_CH))
+    buf[n++] = (uint8_t)uart_recv(UART_CH);
+  return n;
 }
 
-// convenience
-static int receive_byte(void)
+// Nothing to read: spin for RX_SPIN empty polls (the next byte of a frame is about 87 us away at
+// 115200 baud), then sleep, twice as long each time up to RX_SLEEP_MAX_US. *sleep_us = 0 restarts it.
+#define RX_SPIN 256
+#define RX_SLEEP_MIN_US 50
+#define RX_SLEEP_MAX_US 1000 // 11.5 byte times at 115200 baud: the 16-byte FIFO cannot overflow
+
+static void rx_backoff(int *idle, unsigned *sleep_us)
 {
-  return timeouted_byte(TIMEOUT);
+  if (++*idle <= RX_SPIN)
+    return;
+  *sleep_us = (*sleep_us == 0) ? RX_SLEEP_MIN_US : (*sleep_us * 2 > RX_SLEEP_MAX_US) ? RX_SLEEP_MAX_US : *sleep_us * 2;
+  struct timespec ts = {0, (long)*sleep_us * 1000L};
+  nanosleep(&ts, NULL);
+}
+
+static unsigned rx_now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned)(ts.tv_sec * 1000u + ts.tv_nsec / 1000000);
 }
 
 // [DST][SRC][LEN][PAYLOAD]
@@ -215,84 +226,282 @@ void send_message_raw(uint8_t dst, uint8_t src, const uint8_t payload[], uint8_t
 #define send_message(dst, src, payload) \
   send_message_raw(dst, src, payload, (uint8_t)sizeof(payload))
 
-// receive a message into globals g_src, g_len, g_payload
-// receive_message
-// UPDATED: Now non-blocking. Returns -1 immediately if no data.
-static int receive_message(void)
+// -------- UART receive thread ----------
+// rx_thread owns the RX side: it drains the FIFO in bursts and assembles frames as they come in,
+// no matter what the main loop is busy with (a step, the display, the persistence write). Frames for
+// the master land in a lock-free single-producer / single-consumer ring that receive_message pops
+// without blocking; the master starts the ring, so frames for anyone else came all the way round
+// unclaimed and end here.
+
+#define RX_FRAMES 16 // ring slots, power of two
+
+typedef struct
 {
-  if (!uart_has_data(UART_CH))
-    return -1;
+  uint8_t src, len;
+  uint8_t payload[MAX_PAY];
+} rx_frame;
 
-  int b = receive_byte(); // DST
-  if (b < 0)
-    return -1;
-  uint8_t dst = (uint8_t)b;
+static rx_frame g_rx_ring[RX_FRAMES];
+static unsigned g_rx_head = 0; // next slot rx_thread fills, only rx_thread writes it
+static unsigned g_rx_tail = 0; // next slot receive_message pops, only the main loop writes it
 
-  b = receive_byte(); // SRC
-  if (b < 0)
-    return -1;
-  uint8_t src = (uint8_t)b;
+// queue a frame for the main loop (payload clamped to MAX_PAY like before)
+static void rx_push(uint8_t src, const uint8_t payload[], int len)
+{
+  unsigned head = g_rx_head;
+  if (head - __atomic_load_n(&g_rx_tail, __ATOMIC_ACQUIRE) == RX_FRAMES)
+    return; // main loop this far behind: drop it, the request times out and is sent again
+
+  rx_frame *f = &g_rx_ring[head % RX_FRAMES];
+  f->src = src;
+  f->len = (uint8_t)((len > MAX_PAY) ? MAX_PAY : len);
+  memcpy(f->payload, payload, f->len);
+  __atomic_store_n(&g_rx_head, head + 1, __ATOMIC_RELEASE); // publish only once the slot is filled
+}
 
-  b = receive_byte(); // LEN
-  if (b < 0)
-    return -1;
-  uint8_t len = (uint8_t)b;
+// Frame assembler: rebuilds [DST][SRC][LEN][PAYLOAD] from the bursts, however the frames are cut up
+// between them. Only frames for the master are kept.
+enum { RX_DST, RX_SRC, RX_LEN, RX_PAYLOAD };
 
-  // If not for me, drain payload so framing stays aligned.
-  if (dst != MSTR)
+#define RX_FILL 0xFF // a node pads a frame it had to cut off with it. No frame ends in it otherwise
+
+typedef struct
+{
+  int state; // RX_*: the byte expected next
+  int mine;  // this frame is for the master
+  uint8_t src, len;
+  int n;     // payload bytes so far
+  uint8_t payload[255];
+  unsigned last_ms; // when the frame last got a byte
+} rx_assembler;
+
+static void rx_byte(rx_assembler *a, uint8_t b)
+{
+  switch (a->state)
   {
-    for (int i = 0; i < len; i++)
+  case RX_DST:
+    a->mine = (b == MSTR);
+    a->state = RX_SRC;
+    return;
+  case RX_SRC:
+    a->src = b;
+    a->state = RX_LEN;
+    return;
+  case RX_LEN:
+    a->len = b;
+    a->n = 0;
+    a->state = RX_PAYLOAD;
+    break;
+  default:
+    a->payload[a->n++] = b;
+    break;
+  }
+
+  if (a->n == a->len) // complete
+  {
+    if (a->mine && (a->n == 0 || a->payload[a->n - 1] != RX_FILL)) // not one a node had to cut off
+      rx_push(a->src, a->payload, a->n);
+    a->state = RX_DST;
+  }
+}
+
+// the frame stalled TIMEOUT ms: drop it
+static void rx_abort(rx_assembler *a)
+{
+  a->state = RX_DST;
+}
+
+#define RX_BURST 64 // bytes per read, more than the FIFO holds
+
+static void *rx_thread(void *arg)
+{
+  (void)arg;
+  rx_assembler a;
+  memset(&a, 0, sizeof(a));
+  uint8_t buf[RX_BURST];
+  int idle = 0;
+  unsigned sleep_us = 0;
+
+  while (1)
+  {
+    int n = uart_read_burst(buf, RX_BURST);
+    if (n > 0)
     {
-      (void)receive_byte(); // ignore; if timeout happens, we just desync less badly than leaving bytes behind
+      for (int i = 0; i < n; i++)
+        rx_byte(&a, buf[i]);
+      a.last_ms = rx_now_ms();
+      idle = 0;
+      sleep_us = 0;
+      continue;
     }
-    return 0;
+    if (a.state != RX_DST && rx_now_ms() - a.last_ms >= TIMEOUT)
+      rx_abort(&a);
+    rx_backoff(&idle, &sleep_us);
   }
+  return NULL;
+}
 
-  if (len > MAX_PAY)
-    len = MAX_PAY;
-
-  for (int i = 0; i < len; i++)
+// start rx_thread, once the UART is set up
+static void rx_start(void)
+{
+  pthread_t t;
+  if (pthread_create(&t, NULL, rx_thread, NULL) != 0)
   {
-    b = receive_byte();
-    if (b < 0)
-      return -3;
-    g_payload[i] = (uint8_t)b;
+    perror("rx thread");
+    exit(1);
   }
+  pthread_detach(t);
+}
+
+// take the oldest frame for this node into g_src, g_len, g_payload. Never blocks:
+// returns its length, or -1 if there is none
+static int receive_message(void)
+{
+  unsigned tail = g_rx_tail;
+  if (tail == __atomic_load_n(&g_rx_head, __ATOMIC_ACQUIRE))
+    return -1;
 
-  g_src = src;
-  g_len = len;
+  const rx_frame *f = &g_rx_ring[tail % RX_FRAMES];
+  g_src = f->src;
+  g_len = f->len;
+  memcpy(g_payload, f->payload, f->len);
+  __atomic_store_n(&g_rx_tail, tail + 1, __ATOMIC_RELEASE); // slot free again
   return (int)g_len;
 }
 
 // Ping / random / sensor / motor commands
 
-// send a ping to a module and expect 'A' back
-#define BOOT_PING_TOTAL_MS 1500 // total time to wait for module to answer
-#define BOOT_PING_RETRY_MS 100  // resend 'A' every 100ms
+// REQUEST / RESPONSE
+// A request is [cmd, seq]: the last payload byte is a sequence number, and the node echoes it as the
+// last byte of its reply ([cmd, value, seq], or [cmd, seq] for a plain ack). That is what lets
+// requests to different nodes be out at the same time: a reply is matched to its request by node,
+// command and seq, so a late one can never pass for the answer to a newer request. Replies nobody
+// waits for any more are dropped.
 
-static int boot_ping(uint8_t dst)
+#define REQ_SLOTS 8 // requests out at once
+
+typedef struct
+{
+  int busy; // slot in use, until req_wait
+  int done; // answered or timed out
+  uint8_t dst, cmd, seq;
+  unsigned sent_ms;
+  int timeout_ms;
+  int value; // reply byte after the command (0 for a plain ack), -1 = timed out
+} req_slot;
+
+static req_slot g_req[REQ_SLOTS];
+static uint8_t g_req_seq = 0;
+
+// send [cmd, args..., seq] to dst, answer due within timeout_ms. returns the slot to req_wait on,
+// -1 if all REQ_SLOTS are out
+static int req_send_args(uint8_t dst, uint8_t cmd, const uint8_t args[], int nargs, int timeout_ms)
+{
+  for (int i = 0; i < REQ_SLOTS; i++)
+  {
+    req_slot *r = &g_req[i];
+    if (r->busy)
+      continue;
+    r->busy = 1;
+    r->done = 0;
+    r->dst = dst;
+    r->cmd = cmd;
+    if (g_req_seq == RX_FILL)
+      g_req_seq++; // the request's last byte, and a cut-off frame ends in RX_FILL
+    r->seq = g_req_seq++;
+    r->sent_ms = rx_now_ms();
+    r->timeout_ms = timeout_ms;
+    r->value = -1;
+    uint8_t payload[MAX_PAY];
+    int n = 0;
+    payload[n++] = cmd;
+    for (int k = 0; k < nargs && n < MAX_PAY - 1; k++)
+      payload[n++] = args[k];
+    payload[n++] = r->seq;
+    send_message_raw(dst, MSTR, payload, (uint8_t)n);
+    return i;
+  }
+  return -1;
+}
+
+static int req_send(uint8_t dst, uint8_t cmd, int timeout_ms)
 {
-  uint8_t payload[] = {'A'};
+  return req_send_args(dst, cmd, NULL, 0, timeout_ms);
+}
 
-  int waited = 0;
-  int since_send = BOOT_PING_RETRY_MS; // force immediate send first iteration
+// vitals the sensor nodes pushed on their own (see PUBLISH / SUBSCRIBE), -1 = none yet
+static int g_pub_value[2] = {-1, -1}; // [0] heartbeat, [1] crying
+static unsigned g_pub_ms[2];          // when each came in
 
-  while (waited < BOOT_PING_TOTAL_MS)
+// match every queued reply to its request, file the pushed vitals, and time out the requests past
+// their deadline
+static void req_poll(void)
+{
+  int n;
+  while ((n = receive_message()) >= 0)
   {
-    if (since_send >= BOOT_PING_RETRY_MS)
+    // ['P', cmd, value]: only the reading each node was subscribed for, 'H' from HRTBT and 'C' from CRY
+    if (n >= 3 && g_payload[0] == 'P' &&
+        ((g_src == HRTBT && g_payload[1] == 'H') || (g_src == CRY && g_payload[1] == 'C')))
     {
-      send_message(dst, MSTR, payload);
-      since_send = 0;
+      int k = (g_src == HRTBT) ? 0 : 1;
+      g_pub_value[k] = g_payload[2];
+      g_pub_ms[k] = rx_now_ms();
+      continue;
     }
+    if (n < 2)
+      continue; // no seq: not an answer to anything
+    for (int i = 0; i < REQ_SLOTS; i++)
+    {
+      req_slot *r = &g_req[i];
+      if (r->busy && !r->done && r->dst == g_src && r->cmd == g_payload[0] && r->seq == g_payload[n - 1])
+      {
+        r->value = (n >= 3) ? g_payload[1] : 0;
+        r->done = 1;
+        break;
+      }
+    }
+  }
 
-    int r = receive_message();
-    if (r > 0 && g_src == dst && g_len >= 1 && g_payload[0] == 'A')
-      return 1;
+  unsigned now = rx_now_ms();
+  for (int i = 0; i < REQ_SLOTS; i++)
+    if (g_req[i].busy && !g_req[i].done && now - g_req[i].sent_ms >= (unsigned)g_req[i].timeout_ms)
+      g_req[i].done = 1;
+}
 
+// wait until request i is answered or timed out and free its slot: the reply value, -1 on timeout
+static int req_wait(int i)
+{
+  if (i < 0)
+    return -1;
+  for (req_poll(); !g_req[i].done; req_poll())
     sleep_msec(1);
-    waited += 1;
-    since_send += 1;
-  }
+  g_req[i].busy = 0;
+  return g_req[i].value;
+}
+
+// req_wait without the wait, for requests nobody blocks on: -2 while request i is still out (slot
+// kept), else its slot is freed and the reply value returned, -1 on timeout
+static int req_check(int i)
+{
+  if (i < 0)
+    return -1;
+  if (!g_req[i].done)
+    return -2;
+  g_req[i].busy = 0;
+  return g_req[i].value;
+}
+
+
+// send a ping to a module and expect 'A' back
+#define BOOT_PING_TOTAL_MS 1500 // total time to wait for module to answer
+#define BOOT_PING_RETRY_MS 100  // resend 'A' every 100ms
+
+static int boot_ping(uint8_t dst)
+{
+  for (int waited = 0; waited < BOOT_PING_TOTAL_MS; waited += BOOT_PING_RETRY_MS)
+    if (req_wait(req_send(dst, 'A', BOOT_PING_RETRY_MS)) >= 0)
+      return 1;
   return 0;
 }
 
@@ -317,60 +526,89 @@ static int boot_ping(uint8_t dst)
 //   return -1; // timeout
 // }
 
-// request heartbeat value
-static void drain_my_rx(void)
+// request heartbeat value: the heartbeat node answers from a slower loop than the crying node
+#define HB_REPLY_MS 200
+
+static int request_heartbeat(void)
 {
-  // Drain any already-buffered frames addressed to MSTR.
-  // This prevents "one-cycle behind" by removing late replies from previous requests.
-  while (uart_has_data(UART_CH))
-  {
-    int r = receive_message();
-    if (r < 0) break; // no complete frame available right now
-  }
+  return req_wait(req_send(HRTBT, 'H', HB_REPLY_MS));
 }
 
-static int request_heartbeat(void)
+// request crying value
+static int request_crying(void)
 {
-  // 1) Remove any stale/late replies
-  drain_my_rx();
+  return req_wait(req_send(CRY, 'C', TIMEOUT));
+}
 
-  // 2) Send request
-  uint8_t payload[] = {'H'};
-  send_message(HRTBT, MSTR, payload);
+// both vitals in one ring traversal: the two requests go out back to back and come back together,
+// instead of one round trip after the other. -1 for a value that did not come in time
+static void request_vitals(int *bpm, int *cry)
+{
+  int h = req_send(HRTBT, 'H', HB_REPLY_MS);
+  int c = req_send(CRY, 'C', TIMEOUT);
+  *cry = req_wait(c);
+  *bpm = req_wait(h);
+}
 
-  // 3) Wait long enough for the heartbeat node to respond (NOT 20 ms)
-  // Start with 200 ms; adjust if needed.
-  const int WAIT_MS = 200;
+// PUBLISH / SUBSCRIBE
+// Polling costs a round trip per reading. Instead the master subscribes to both sensor nodes
+// (['S', cmd, period / 10 ms, delta, seq]), and from then on each node pushes ['P', cmd, value]
+// on its own: at once when the value moved by more than VITALS_DELTA, and every VITALS_POLL_MS
+// anyway. req_poll files the pushes, so the master always holds fresh vitals and the ring only
+// carries changes and that keep-alive. A node that restarts forgets its subscription: once its
+// pushes have been missing for VITALS_STALE_MS, the master polls instead and subscribes again.
+// The subscription goes out without waiting: req_poll collects the ack like any reply.
+#define VITALS_DELTA 2                      // BPM or crying %
+#define VITALS_STALE_MS (3 * VITALS_POLL_MS) // pushes missing this long: the subscription is gone
+#define VITALS_RESUBSCRIBE_MS 1000          // and ask again at most this often
+
+// ask dst to push its cmd ('H' or 'C') readings: the slot its ack comes back in, -1 if none was free
+static int vitals_subscribe(uint8_t dst, uint8_t cmd)
+{
+  uint8_t args[] = {cmd, VITALS_POLL_MS / 10, VITALS_DELTA};
+  return req_send_args(dst, 'S', args, (int)sizeof(args), (dst == HRTBT) ? HB_REPLY_MS : TIMEOUT);
+}
 
-  int waited = 0;
-  while (waited < WAIT_MS)
+// the latest vitals: the pushed ones while both subscriptions are alive, a polled round otherwise
+static void vitals_get(int *bpm, int *cry)
+{
+  static const uint8_t node[2] = {HRTBT, CRY};
+  static const uint8_t cmd[2] = {'H', 'C'};
+  static unsigned subscribed_ms[2];
+  static int tried[2];
+  static int ack[2] = {-1, -1}; // slot of a subscription still waiting for its ack
+
+  req_poll();
+  unsigned now = rx_now_ms();
+  int stale = 0;
+  for (int k = 0; k < 2; k++)
   {
-    int r = receive_message();
-    if (r > 0 && g_src == HRTBT && g_len >= 2 && g_payload[0] == 'H')
-      return g_payload[1];
+    int v = req_check(ack[k]);
+    if (v != -2)
+    {
+      if (v >= 0)
+        log_printf("[V] %s pushes its readings\n", (node[k] == HRTBT) ? "HB" : "CRY");
+      ack[k] = -1;
+    }
 
-    sleep_msec(1);
-    waited += 1;
+    if (g_pub_value[k] >= 0 && now - g_pub_ms[k] <= VITALS_STALE_MS)
+      continue;
+    stale = 1;
+    if (ack[k] < 0 && (!tried[k] || now - subscribed_ms[k] >= VITALS_RESUBSCRIBE_MS))
+    {
+      tried[k] = 1;
+      subscribed_ms[k] = now;
+      ack[k] = vitals_subscribe(node[k], cmd[k]);
+    }
   }
-  return -1;
-}
 
-
-// request crying value
-static int request_crying(void)
-{
-  uint8_t payload[] = {'C'};
-  send_message(CRY, MSTR, payload);
-  int waited = 0;
-  while (waited < TIMEOUT)
+  if (stale)
   {
-    int r = receive_message();
-    if (r > 0 && g_src == CRY && g_len >= 2 && g_payload[0] == 'C')
-      return g_payload[1];
-    sleep_msec(1);
-    waited += 1;
+    request_vitals(bpm, cry);
+    return;
   }
-  return -1;
+  *bpm = g_pub_value[0];
+  *cry = g_pub_value[1];
 }
 
 // send motor command (amp%, freq%)
@@ -399,35 +637,27 @@ static void command_motor(uint8_t amp, uint8_t freq)
 //   send_message(MTR, MSTR, pl);
 // }
 
-// Controller state + logic
-
-// A/F grid (0-4). Start at A5 F5
-static int curA = 4;
-static int curF = 4;
+// Controller state + logic live in controller.c, shared with the simulator
+static controller_state g_ctl;
 
-static int is_crying_activated = 0;
-static int ctrl_lastBPM = -1;
-static int ctrl_lastCRY = -1;
-static int thresholdBPM = 10;
-static int thresholdCRY = 1;
+// which search controller_step runs: CTRL_MODE_ANCHOR (LEFT-then-UP anchors), CTRL_MODE_BELIEF
+// (belief over the 70 K paths), CTRL_MODE_MPC (belief + rollouts) or CTRL_MODE_TABLE (policy_table.h).
+// Compare them with ../sim/sim -b N -c all before flashing.
+#ifndef CONTROLLER_MODE
+#define CONTROLLER_MODE CTRL_MODE_ANCHOR
+#endif
 
-static int prevA = -1;
-static int prevF = -1;
+// PERSISTENCE
+// restart_program execs a fresh copy and a power cycle starts one too, both from controller_init. What
+// the controller learned is kept in CTRL_SNAPSHOT_PATH (relative to the working directory, which the
+// exec keeps) and the live loop reloads it at boot. The board keeps no time across a power cycle, so
+// the snapshot cannot tell a new baby: hold button 0 while it boots to start cold instead.
+#ifndef CTRL_SNAPSHOT_PATH
+#define CTRL_SNAPSHOT_PATH "decision.snap"
+#endif
 
-static int anchorA_mem = -1, anchorF_mem = -1;
-static int triedLeftFromAnchor = 0;
-static int triedUpFromAnchor = 0;
-
-// 0 = none/initial, 1 = LEFT, 2 = UP
-static int lastMoveDir = 0;
-
-static int hit_wall = 0; // 1 if we attempted a direction but boundary blocked this cycle
-
-// anchor map discovered so far (0 = unknown)
-static int anchorMatrix[5][5] = {0};
-static int anchorLevel = 0;
-
-static int panic_mode = 0;
+static controller_snapshot g_snap; // what is on disk
+static int g_persist = 0;          // live mode only, the demo's vitals are made up
 
 // timing
 static double g_algo_start_ms = 0.0;
@@ -459,6 +689,7 @@ static void fmt_mmss(int ms, char out[8])
 }
 
 // Map logical cell (A,F) -> actual motor amplitude/frequency percentages.
+// The controller already clamped and made it current; this only talks to the motor node.
 static void controller_command_cell(int aIndex, int fIndex)
 {
   if (aIndex < 0)
@@ -476,13 +707,10 @@ static void controller_command_cell(int aIndex, int fIndex)
   // uint8_t amp = amp_levels[aIndex];
   // uint8_t freq = freq_levels[fIndex];
 
-  curA = aIndex;
-  curF = fIndex;
-
-  command_motor(curA, curF);
+  command_motor(aIndex, fIndex);
   // ---- CALM detection (A1F1 == indices 0,0) ----
   // We only count calm if we are NOT in panic mode (panic currently forces A1F1).
-  if (!g_calm_reached && !panic_mode && g_algo_start_ms > 0.0 && curA == 0 && curF == 0)
+  if (!g_calm_reached && !g_ctl.panic_mode && g_algo_start_ms > 0.0 && aIndex == 0 && fIndex == 0)
   {
     g_calm_reached = 1;
     g_calm_elapsed_ms = (int)(now_msec() - g_algo_start_ms);
@@ -490,296 +718,55 @@ static void controller_command_cell(int aIndex, int fIndex)
   }
 }
 
-// improvement tests (from sim)
-static int heartbeat_improved(int bpm_now)
+// temp file, fsync, rename: a power cut leaves the old snapshot or the new one, never half of each
+static void snapshot_write(void)
 {
-  if (ctrl_lastBPM <= 0)
-    return 0;
-  if (ctrl_lastBPM - bpm_now >= thresholdBPM)
-    return 1;
-  return 0;
+  const char *tmp = CTRL_SNAPSHOT_PATH ".tmp";
+  FILE *fp = fopen(tmp, "wb");
+  if (!fp)
+    return;
+  int ok = fwrite(&g_snap, sizeof(g_snap), 1, fp) == 1 && fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+  if (fclose(fp) != 0 || !ok || rename(tmp, CTRL_SNAPSHOT_PATH) != 0)
+    remove(tmp);
 }
 
-static int crying_improved(int cry_now)
+// after anything that may have changed the controller: write the snapshot if it did
+static void snapshot_save(void)
 {
-  if (cry_now <= thresholdCRY)
-    return 1;
-  if (ctrl_lastCRY > 0 && (ctrl_lastCRY - cry_now >= thresholdCRY))
-    return 1;
-  return 0;
+  if (!g_persist)
+    return;
+  controller_snapshot snap;
+  controller_save(&g_ctl, &snap);
+  if (memcmp(&snap, &g_snap, sizeof(snap)) == 0)
+    return;
+  g_snap = snap;
+  snapshot_write();
 }
 
-// register anchor cell
-static void register_anchor(int a, int f)
+// warm start, right after controller_init: 1 if the controller picked up the snapshot
+static int snapshot_load(void)
 {
-  if (a < 0 || a > 4 || f < 0 || f > 4)
-    return;
-
-  if (anchorMatrix[a][f] == 0)
-  {
-    anchorLevel++;
-    anchorMatrix[a][f] = 10 - anchorLevel;
-    log_printf("[A] set A%d F%d as anchor L%d\n",
-               a + 1, f + 1, anchorLevel);
-  }
+  controller_snapshot snap;
+  FILE *fp = fopen(CTRL_SNAPSHOT_PATH, "rb");
+  if (!fp)
+    return 0;
+  int got = fread(&snap, sizeof(snap), 1, fp) == 1;
+  fclose(fp);
+  if (!got || controller_restore(&g_ctl, &snap) != 0)
+    return 0;
+  g_snap = snap;
+  return 1;
 }
 
-// One controller step for
-// This function is called every control cycle with the latest BPM and CRY and decides what to command on the motor grid.
-// Yes this is extensively documented so that everyone can understand. Yes including me.
-// bpm_now is the current heartbeat in BPM, cry_now is the current crying level (%) both are measured by the submodules, hopefully.
-static void controller_step(int bpm_now, int cry_now)
+// One control cycle: let the shared controller decide, then drive the motor node.
+static void run_controller_step(int bpm_now, int cry_now)
 {
-  hit_wall = 0; // Detector flag for (AxF1 or A1Fx so we can be smart and reduce the delay to just the convergence time)
-
-  // PANIC DETECTION USING VITALS
-  // In this part we look only at BPM and CRY and decide whether the baby is in a panic state and we must enter panic_mode.
-  // This matters because if we are in panic mode we need to go to K9 to start again. Currently the motors stop for testing purposes
-
-  int big_jump = 0; // This variable will be set to 1 if the BPM suddenly jumps up a lot compared to the previous BPM
-
-  if (ctrl_lastBPM > 0)                        // We only check for a BPM jump if we have a valid previous BPM
-    big_jump = (bpm_now - ctrl_lastBPM >= 30); // Here we compute the difference between current BPM and last BPM, and set big_jump to 1 if the increase is 30 BPM or more.
-
-  if (!panic_mode) // We only re-check panic conditions if we are not already in panic mode; once in panic, we stay there until its reseted somehow (not implement rk).
-  {
-    if (big_jump) // If any of our panic flags are true, panic.
-    {
-      panic_mode = 1; // We now enter panic mode, meaning that the rest of this function will follow the panic-mode path instead of the normal algorithm.
-
-      log_printf("[A] PANIC(BPM=%d, CRY=%d)\n", bpm_now, cry_now); // We log a message so we can see exactly when and with what values the panic was triggered.
-    }
-  }
-
-  // PANIC MODE: FREEZE MOTORS (Currently)
-  // When panic_mode is active, we stop exploring the (A, F) grid and keep the cradle in a fixed safe motor state.
-
-  if (panic_mode)
-  {
-    controller_command_cell(0, 0); // We command the cell at indices (A=0, F=0)
-
-    ctrl_lastBPM = bpm_now; // We still update ctrl_lastBPM to the current BPM so history and logs remain up to date even during panic.
-    ctrl_lastCRY = cry_now; // We also update ctrl_lastCRY to the current crying level for the same reason.
-    return;                 // We leave the function early because, in panic mode, we do not want to run the normal inverse-model algorithm anymore.
-  }
-
-  // NORMAL MODE: CHECK WHETHER THE LAST MOVE HELPED OR NOT
-  // Since we are not in panic, we now look at whether the last motor command improved the baby’s state.
-
-  int improved = 0; // This will be set to 1 if the helper functions say that the situation actually got better after the last move.
-  int same = 0;     // This will be set to 1 if the situation is considered stable
-
-  if (bpm_now < 150 && (cry_now < 52 && cry_now > 15)) // If the current BPM is below 150, we stop using heart rate as its delayed and focus more on crying as an indicator of stress.
-  {
-    is_crying_activated = 1;             // We record that in this regime we are using crying as the primary signal to measure improvement.
-    improved = crying_improved(cry_now); // We call crying_improved with the current CRY value. returns 1 if crying suggests improvement.
-  }
-  else // If BPM is 150 or higher, the heart rate is used since crying is always %100 here
-  {
-    is_crying_activated = 0;                // We record that, in this regime, we are using BPM as the primary indicator of improvement.
-    improved = heartbeat_improved(bpm_now); // We call heartbeat_improved with the current BPM value. returns 1 if BPM suggests improvement
-  }
-
-  if (ctrl_lastBPM > 0) // We  attempt a “stability” check (if we have a valid previous BPM value otherwise we cannot compare)
-  {
-    int bpm_delta = abs(bpm_now - ctrl_lastBPM);                           // We calculate the absolute value of the difference between current BPM and last BPM to see how much it changed.
-    int cry_delta = (ctrl_lastCRY >= 0) ? abs(cry_now - ctrl_lastCRY) : 0; // For CRY, we do a similar absolute difference if we have a valid previous value; otherwise we treat it as zero change.
-
-    if (!is_crying_activated) // If we are currently in BPM-driven mode (using BPM to decide improvement),
-    {
-      if (bpm_delta <= 3) // then we consider the state “stable” if BPM changed by at most 3 beats since the last step.
-      {
-        log_printf("[A] HB stable Del(BPM)=%d\n", bpm_delta);
-        if (lastMoveDir == 1) // If the last move we made on the grid was a LEFT move (direction 1),
-          same = 1;           // we set same to 1, meaning we have a “stable after LEFT” pattern that we will react to with a special move i call reverse diagonal later.
-      }
-    }
-    else // If we are in crying-driven mode (using CRY to decide improvement),
-    {
-      if (cry_delta == 0) // we treat the situation as stable only if crying did not change at all (difference equals zero).
-      {
-        log_printf("[A] CRY stable ΔCRY=%d\n", cry_delta); // We log that the crying level is stable and show the CRY difference (which is zero here).
-        if (lastMoveDir == 1)                              // Again, this only matters if the last move direction was LEFT,
-          same = 1;                                        // so we set same to 1 in that case to remember the “stable after LEFT” condition.
-      }
-    }
-  }
-
-  // ANCHOR SYNC WHEN IDLE (lastMoveDir == 0)
-  // Anchors are positions on the grid that we know are in the solution path
-  // when idle we make sure our stored anchor matches our current position.
-
-  if (lastMoveDir == 0) // If lastMoveDir is 0, it means we are not in the middle of a move and are sitting on some anchor position.
-  {
-    if (anchorA_mem != curA || anchorF_mem != curF) // If the anchor stored in memory does not match our current (curA, curF) on the grid,
-    {
-      anchorA_mem = curA;      // we update the stored anchor amplitude index to the current A index.
-      anchorF_mem = curF;      // we also update the stored anchor frequency index to the current F index.
-      triedLeftFromAnchor = 0; // We reset the flag indicating whether we have tried going LEFT from this anchor, so it becomes allowed again.
-      triedUpFromAnchor = 0;   // We also reset the flag indicating whether we have tried going UP from this anchor.
-
-      register_anchor(anchorA_mem, anchorF_mem); // We call register_anchor to tell the rest of the system that (curA, curF) is now our chosen anchor cell.
-      // this will later be used to follow a predetermined path to solution if a panic jump is caused to save time
-    }
-  }
-
-  // FIRST MOVE FROM AN ANCHOR (when lastMoveDir == 0)
-  // From an anchor, the algorithm chooses which neighbour to explore first (LEFT or UP).
-
-  if (lastMoveDir == 0) // We are in the idle state, so now we decide the first exploration step from this anchor.
-  {
-    prevA = curA; // We store the current amplitude index as prevA, so we can return here later if needed.
-    prevF = curF; // We also store the current frequency index as prevF for the same reason.
-    if (!triedLeftFromAnchor && curF == 0)
-    {
-      hit_wall = 1; // wanted to try LEFT but wall
-      controller_command_cell(curA - 1, curF);
-      log_printf("[A] Hit left wall\n");
-    }
-    else if (!triedUpFromAnchor && curA == 0)
-    {
-      hit_wall = 1; // wanted to try UP but wall
-      controller_command_cell(curA, curF - 1);
-      log_printf("[A] Hit upper wall\n");
-    }
-    // just to be sure we still check vitals after we hit a wall instead of just going down.
-
-    else if (!triedLeftFromAnchor && curF > 0) // If we have not already tried going LEFT from this anchor and we are not at the left border of the grid (F > 0),
-    {
-      lastMoveDir = 1;         // We set lastMoveDir to 1 to remember that we are now making a LEFT move.
-      triedLeftFromAnchor = 1; // We also mark that from this anchor, LEFT has now been attempted, so we do not retry it immediately later.
-
-      log_printf("[A] TRY-> LEFT from A%d F%d\n", curA + 1, curF + 1);
-
-      controller_command_cell(curA, curF - 1); // We send the actual motor command to move to the cell with the same A index and F index decreased by one (one step LEFT on the grid).
-
-      ctrl_lastBPM = bpm_now; // After issuing the command, we record the current BPM so that next time we can compare and see if there was improvement.
-      ctrl_lastCRY = cry_now; // We also record the current CRY for the same comparison on the next step.
-      return;                 // We return immediately, because we want to wait and see how this LEFT move changes the baby’s vitals before doing anything else.
-    }
-    else if (!triedUpFromAnchor && curA > 0) // If LEFT is not available or already tried, but we have not tried UP and we are not at the top row (A > 0),
-    {
-      lastMoveDir = 2;       // We set lastMoveDir to 2 to indicate that our next move is an UP move.
-      triedUpFromAnchor = 1; // We mark that from this anchor, UP has been attempted, to avoid repeating it unnecessarily.
-
-      log_printf("[A] Blocked-> UP from A%d F%d\n", curA + 1, curF + 1); // We log that our TRY move from this anchor is UP, and note that LEFT was already tried or blocked.
-
-      controller_command_cell(curA - 1, curF); // We send the motor command to move to the neighbour above, which has A index decreased by one and the same F index.
-
-      ctrl_lastBPM = bpm_now; // We store the BPM we saw before this UP move so that we can check later if it improved things.
-      ctrl_lastCRY = cry_now; // We also store the CRY level for the same reason.
-      return;                 // We return here, again to wait for the effect of this UP move on the vitals.
-    }
-    else if (curA + 1 == 1 && curF + 1 == 1) // If neither LEFT nor UP is available (or both have already been tried from this anchor),
-    {
-      log_printf("[A] BABY CALM holding A%d F%d\n", curA + 1, curF + 1);
-
-      ctrl_lastBPM = bpm_now; // Even though we are not moving, we still update the last BPM value to what we just measured.
-      ctrl_lastCRY = cry_now; // And we also update the last CRY value.
-      return;                 // We exit the function while staying at this anchor, just monitoring the baby’s state.
-    }
-    else // If neither LEFT nor UP is available (or both have already been tried from this anchor),
-    {
-      log_printf("[A] Fatal Error! holding A%d F%d\n", curA + 1, curF + 1);
-
-      ctrl_lastBPM = bpm_now; // Even though we are not moving, we still update the last BPM value to what we just measured.
-      ctrl_lastCRY = cry_now; // And we also update the last CRY value.
-      return;                 // We exit the function while staying at this anchor, just monitoring the baby’s state.
-    }
-  }
-
-  // WE HAVE A LAST MOVE (lastMoveDir != 0) // If we reach here, it means we are returning after having commanded a move in the previous step.
-
-  if (improved) // If the helper functions said that the last move improved the situation,
-  {
-    int anchorA = curA; // We now treat the current A index (where we ended up) as a new anchor amplitude index.
-    int anchorF = curF; // We also treat the current F index as a new anchor frequency index.
-
-    log_printf("[A] IMPROVED -> anchor A%d F%d\n", anchorA + 1, anchorF + 1);
-
-    register_anchor(anchorA, anchorF); // We tell the anchor-management logic that this cell (anchorA, anchorF) should be added or updated as an anchor on the path.
-
-    if (anchorA_mem != anchorA || anchorF_mem != anchorF) // If our remembered anchor position does not yet match this new anchor,
-    {
-      anchorA_mem = anchorA;   // we store the new anchor amplitude index in anchorA_mem.
-      anchorF_mem = anchorF;   // and the new anchor frequency index in anchorF_mem.
-      triedLeftFromAnchor = 0; // We reset the “tried left” flag, because this is a fresh anchor and we can try LEFT from it again.
-      triedUpFromAnchor = 0;   // We also reset the “tried up” flag for the same reason.
-    }
-
-    prevA = anchorA; // We also store this anchor as prevA so that, if future moves fail, we can backtrack to it.
-    prevF = anchorF; // And we store it as prevF for backtracking in frequency.
-
-    if (anchorF > 0) // If we are not at the left border, we can try going further LEFT from this new anchor.
-    {
-      lastMoveDir = 1;         // We set the last move direction to LEFT again, as we are planning a follow-up LEFT move.
-      triedLeftFromAnchor = 1; // We mark that LEFT has been tried from this anchor so we do not keep repeating it forever.
-
-      log_printf("[A] IMPROVED-> LEFT from A%d F%d\n", anchorA + 1, anchorF + 1); // We log that, because the last move was good, we are going to continue exploring by moving LEFT from this new anchor.
-
-      controller_command_cell(anchorA, anchorF - 1); // We command the motor module to move to the cell one step LEFT of the current anchor position.
-      // we can shorten delays if borders are hit since there is only going to remain one path to solution so we wouldnt need to wait for the whole heartbeat delay and just the convergence delay. I just dont think this will happen.
-    }
-    else if (anchorA > 0) // Otherwise, if LEFT is impossible but we can still move UP (not at top boundary),
-    {
-      lastMoveDir = 2; // We set the next move direction to UP.
-      // Note: we do not mark triedUpFromAnchor here, but we could if we want symmetric behaviour.
-
-      log_printf("[A] IMPROVED-> try UP from A%d F%d\n", anchorA + 1, anchorF + 1); // We log that we improved and now we will try moving UP from this anchor instead.
-
-      controller_command_cell(anchorA - 1, anchorF); // We command a move to the cell directly above this anchor (one step lower in A index).
-    }
-
-    ctrl_lastBPM = bpm_now; // After planning the next move, we store the current BPM so we can judge the effect in the next step.
-    ctrl_lastCRY = cry_now; // And we also store the current crying level for the same purpose.
-    return;                 // We exit here since the next decision will be made after we see new vitals.
-  }
-  else // If improved is 0, it means the last move did not make things better (it might be the same or worse).
-  {
-    // HANDLE NO-IMPROVEMENT (SAME OR WORSE) // We now decide whether to try a special reverse-diagonal move or just backtrack.
-
-    if (same && lastMoveDir == 1) // If the state is considered “stable” and the last move direction was LEFT (dir=1),
-    {
-      int anchorA = prevA; // we use prevA as the anchor A index from which we came before that LEFT move.
-      int anchorF = prevF; // and prevF as the anchor F index from before that LEFT move.
-
-      if (anchorA > 0) // If we can still move UP from that previous anchor (i.e., we are not at the top row),
-      {
-        log_printf("[A] SAME-> R.D from A%d F%d\n", anchorA + 1, anchorF + 1); // We log that we detected the “same after left” pattern and will now try a reverse diagonal step from that anchor.
-
-        lastMoveDir = 2;       // We set lastMoveDir to 2 because the reverse diagonal involves an UP move from the previous anchor.
-        triedUpFromAnchor = 1; // We mark that, from this anchor, we are now trying UP so we do not keep repeating it unnecessarily.
-
-        prevA = curA; // We store the current A index as prevA so that if this reverse diagonal is bad, we can backtrack back here.
-        prevF = curF; // We also store the current F index as prevF for symmetrical backtracking.
-
-        controller_command_cell(anchorA - 1, anchorF); // We execute the reverse diagonal by commanding the cell that is one step UP from the previous anchor.
-
-        ctrl_lastBPM = bpm_now; // We update ctrl_lastBPM to remember the BPM at the moment we made this reverse diagonal decision.
-        ctrl_lastCRY = cry_now; // And we also update ctrl_lastCRY to remember the CRY level at this moment.
-        return;                 // We return so that on the next call we can see if this reverse diagonal move improved things.
-      }
-    }
-
-    int anchorA = prevA; // If the special case above does not apply or is impossible, we prepare to backtrack to the previous anchor’s A index.
-    int anchorF = prevF; // And we prepare to backtrack to the previous anchor’s F index.
-
-    if (anchorA != curA || anchorF != curF) // If we are not already at that previous anchor cell,
-    {
-      log_printf("[A] NO IMPROVEMENT -> A%d F%d\n", anchorA + 1, anchorF + 1); // We log that there was no improvement and that we are backtracking to that anchor, including the direction we came from.
-
-      controller_command_cell(anchorA, anchorF); // We send the command to move the motor state back exactly to the previous anchor cell on the grid.
-    }
-
-    curA = anchorA; // We update our current amplitude index to the anchor amplitude index we backtracked to.
-    curF = anchorF; // We update our current frequency index to the anchor frequency index we backtracked to.
-
-    lastMoveDir = 0; // We reset lastMoveDir to 0, indicating that we are now idle at an anchor and ready for the next “first move” decision.
-
-    ctrl_lastBPM = bpm_now; // We store the current BPM as the last BPM for the next control step comparison.
-    ctrl_lastCRY = cry_now; // We store the current crying level as the last CRY for the next comparison as well.
-    return;                 // We exit the function; the next call will start again from an anchor in idle state.
-  }
+  controller_input in = {bpm_now, cry_now};
+  controller_output out;
+  controller_step(&g_ctl, &in, &out);
+  if (out.move)
+    controller_command_cell(out.a, out.f);
+  snapshot_save();
 }
 
 // Ctrl+C handler
@@ -828,6 +815,7 @@ int main(void)
   uart_reset_fifos(UART_CH);
   switchbox_set_pin(IO_AR0, SWB_UART0_RX);
   switchbox_set_pin(IO_AR1, SWB_UART0_TX);
+  rx_start(); // from here on frames for the master are queued whatever the main loop does
   switches_init();
   buttons_init();
 
@@ -988,24 +976,12 @@ int main(void)
     g_log_enabled = 1;
 
     // Ensure controller starts from known state (A5 F5)
-    curA = 4;
-    curF = 4;
-    prevA = curA;
-    prevF = curF;
-    lastMoveDir = 0;
-    is_crying_activated = 0;
-    ctrl_lastBPM = -1;
-    ctrl_lastCRY = -1;
-    anchorA_mem = -1;
-    anchorF_mem = -1;
-    triedLeftFromAnchor = 0;
-    triedUpFromAnchor = 0;
-    memset(anchorMatrix, 0, sizeof(anchorMatrix)); // idek wtf this is but hopefully we arent using the anchor matrix
-    anchorLevel = 0;
-    panic_mode = 0;
+    controller_init(&g_ctl);
+    g_ctl.mode = CONTROLLER_MODE;
+    g_ctl.log = log_printf;
 
     // Put motor to start cell so the output line is meaningful immediately
-    controller_command_cell(curA, curF);
+    controller_command_cell(g_ctl.curA, g_ctl.curF);
 
     g_algo_start_ms = now_msec();
     g_calm_reached = 0;
@@ -1013,8 +989,12 @@ int main(void)
 
     // Run demo until switch 0 is turned off
     int cry_flag = 0;
+    uint32_t demo_step_ms = (uint32_t)now_msec();
+    int demo_first = 1;
     while (get_switch_state(0) == 1)
     {
+      uint32_t now = (uint32_t)now_msec();
+
       // --- Buttons (not-edge-detected) ---
       int b0 = get_button_state(0);
       int b1 = get_button_state(1);
@@ -1038,7 +1018,22 @@ int main(void)
       }
 
       // --- Run real decision logic with injected vitals ---
-      controller_step((int)demo_bpm, (int)demo_cry);
+      // same cadence as the live loop: once they settle, at the latest after controller_period_ms
+      controller_sample(&g_ctl, now, (int)demo_bpm, (int)demo_cry);
+      controller_output wd;
+      int step_now = controller_watchdog(&g_ctl, &wd);
+      if (wd.move)
+      {
+        controller_command_cell(wd.a, wd.f);
+        demo_step_ms = now; // the back-out is the move the next step waits for
+      }
+      if (demo_first || step_now || controller_settled(&g_ctl) ||
+          (uint32_t)(now - demo_step_ms) >= (uint32_t)controller_period_ms(&g_ctl))
+      {
+        demo_first = 0;
+        demo_step_ms = now;
+        run_controller_step((int)demo_bpm, (int)demo_cry);
+      }
 
       // --- Draw HUD lines (clear then redraw fixed positions) ---
       clear_text_line(&g_disp, y_demo_bpm, g_fh, RGB_BLACK);
@@ -1064,8 +1059,8 @@ int main(void)
       strcat(buf, "%");
       draw_text(&g_disp, g_fx, x, y_demo_cry, buf, RGB_WHITE);
 
-      // Regime line (uses your global is_crying_activated)
-      if (is_crying_activated)
+      // Regime line (uses the controller's is_crying_activated)
+      if (g_ctl.is_crying_activated)
         strcpy(buf, "[MODE] CRY driven"); // shorter delay
       else
         strcpy(buf, "[MODE] HB driven");
@@ -1073,10 +1068,10 @@ int main(void)
 
       // Controller output cell (curA/curF are your controller state)
       strcpy(buf, "[CTRL] Decided Cell: A");
-      itoa_u((unsigned)(curA + 1), num);
+      itoa_u((unsigned)(g_ctl.curA + 1), num);
       strcat(buf, num);
       strcat(buf, " F");
-      itoa_u((unsigned)(curF + 1), num);
+      itoa_u((unsigned)(g_ctl.curF + 1), num);
       strcat(buf, num);
       draw_text(&g_disp, g_fx, x, y_demo_cell, buf, RGB_CYAN);
 
@@ -1092,8 +1087,8 @@ int main(void)
 
       // Panic indicator
       strcpy(buf, "[PANIC] ");
-      strcat(buf, panic_mode ? "TRIGGERED" : "NOT TRIGGERED");
-      draw_text(&g_disp, g_fx, x, y_demo_panic, buf, panic_mode ? RGB_RED : RGB_GREEN);
+      strcat(buf, g_ctl.panic_mode ? "TRIGGERED" : "NOT TRIGGERED");
+      draw_text(&g_disp, g_fx, x, y_demo_panic, buf, g_ctl.panic_mode ? RGB_RED : RGB_GREEN);
       int elapsed_ms = g_calm_reached ? g_calm_elapsed_ms : (int)(now_msec() - g_algo_start_ms);
       char tbuf[8];
       fmt_mmss(elapsed_ms, tbuf);
@@ -1103,21 +1098,7 @@ int main(void)
       strcat(buf, g_calm_reached ? " (CALM)" : "");
       draw_text(&g_disp, g_fx, x, y_demo_time, buf, g_calm_reached ? RGB_GREEN : RGB_WHITE);
 
-      int delay_ms_s;
-      if (hit_wall)
-      {
-        delay_ms_s = CONVERGENCE_DELAY;
-      }
-      else if (is_crying_activated)
-      {
-        delay_ms_s = CRYING_DELAY;
-      }
-      else
-      {
-        delay_ms_s = HEARTBEAT_DELAY;
-      }
-
-      sleep_msec(delay_ms_s);
+      sleep_msec(TAU_SAMPLE_MS);
     }
 
     // Exit demo mode cleanly
@@ -1301,11 +1282,9 @@ if (get_switch_state(1) == 1)
   y += g_fh;
 
   // init controller start cell = A5 F5
-  curA = 4;
-  curF = 4;
-  prevA = curA;
-  prevF = curF;
-  lastMoveDir = 0;
+  controller_init(&g_ctl);
+  g_ctl.mode = CONTROLLER_MODE;
+  g_ctl.log = log_printf;
   g_algo_start_ms = now_msec();
   g_calm_reached = 0;
   g_calm_elapsed_ms = 0;
@@ -1323,15 +1302,21 @@ if (get_switch_state(1) == 1)
   g_log_y = g_log_y_start;
   g_log_enabled = 1;
 
+  // warm start from the snapshot the last run left (see PERSISTENCE)
+  g_persist = 1;
+  if (get_button_state(0))
+    remove(CTRL_SNAPSHOT_PATH); // new baby: forget the old one
+  else if (snapshot_load())
+    log_printf("[S] resumed from %s\n", CTRL_SNAPSHOT_PATH);
+
   //uint32_t last_poll_ms = 0;
   uint32_t last_step_ms = 0;
 
   // right after boot_ping() and before entering the while(1)
 for (int i = 0; i < 50; i++) {           // ~1 second at 20ms
-  int vhb = request_heartbeat();
+  int vhb, vcr;
+  vitals_get(&vhb, &vcr);
   if (vhb >= 0) last_bpm = (uint8_t)vhb;
-
-  int vcr = request_crying();
   if (vcr >= 0) last_cry = (uint8_t)vcr;
 
   if (last_bpm != 0 || last_cry != 0) break;
@@ -1354,27 +1339,37 @@ for (int i = 0; i < 50; i++) {           // ~1 second at 20ms
     if (get_button_state(3))
       restart_program();
 
-    // (1) Poll vitals frequently
-    int vhb = request_heartbeat();
-      if (vhb >= 0)
-        last_bpm = (uint8_t)vhb;
-   
-    last_cry=0;
-
-    // (2) Run controller step on your intended cadence (4s or 10s)
-    int step_period_ms;
-    if (hit_wall)
-      step_period_ms = CONVERGENCE_DELAY;
-    else if (is_crying_activated)
-      step_period_ms = CRYING_DELAY;
-    else
-      step_period_ms = HEARTBEAT_DELAY;
+    // (1) Latest vitals: pushed by the sensor nodes, polled while a subscription is down
+    int vhb, vcr;
+    vitals_get(&vhb, &vcr);
+    if (vhb >= 0)
+      last_bpm = (uint8_t)vhb;
+    if (vcr >= 0)
+      last_cry = (uint8_t)vcr;
+
+    // every poll feeds the TAU estimate, which sizes the heartbeat wait in controller_period_ms
+    controller_sample(&g_ctl, now, (int)last_bpm, (int)last_cry);
+
+    // mid-step watchdog: a move that clearly hurt is backed out (or judged) right away
+    controller_output wd;
+    int step_now = controller_watchdog(&g_ctl, &wd);
+    if (wd.move && mtr_ok)
+      controller_command_cell(wd.a, wd.f);
+    if (wd.move)
+    {
+      last_step_ms = now; // the back-out is the move the next step waits for
+      snapshot_save();
+    }
+
+    // (2) Run controller step as soon as the last move has settled, at the latest after the
+    // fixed cadence (4s or 10s)
+    int step_period_ms = controller_period_ms(&g_ctl);
 
-    if ((uint32_t)(now - last_step_ms) >= (uint32_t)step_period_ms)
+    if ((uint32_t)(now - last_step_ms) >= (uint32_t)step_period_ms || step_now || controller_settled(&g_ctl))
     {
       last_step_ms = now;
       if (mtr_ok)
-        controller_step((int)last_bpm, (int)last_cry);
+        run_controller_step((int)last_bpm, 0); // the step judges on BPM as before, crying only feeds the samples
     }
 
     // 3) HUD update and clear
@@ -1401,8 +1396,8 @@ for (int i = 0; i < 50; i++) {           // ~1 second at 20ms
     strcat(buf, "%");
     draw_text(&g_disp, g_fx, x, y_live_cry, buf, RGB_WHITE);
 
-    // MODE (uses is_crying_activated)
-    if (is_crying_activated)
+    // MODE (uses g_ctl.is_crying_activated)
+    if (g_ctl.is_crying_activated)
       strcpy(buf, "[MODE] CRY driven");
     else
       strcpy(buf, "[MODE] HB driven");
@@ -1410,10 +1405,10 @@ for (int i = 0; i < 50; i++) {           // ~1 second at 20ms
 
     // CELL (curA/curF)
     strcpy(buf, "[CTRL] Decided Cell: A");
-    itoa_u((unsigned)(curA + 1), num);
+    itoa_u((unsigned)(g_ctl.curA + 1), num);
     strcat(buf, num);
     strcat(buf, " F");
-    itoa_u((unsigned)(curF + 1), num);
+    itoa_u((unsigned)(g_ctl.curF + 1), num);
     strcat(buf, num);
     draw_text(&g_disp, g_fx, x, y_live_cell, buf, RGB_CYAN);
 
@@ -1429,8 +1424,8 @@ for (int i = 0; i < 50; i++) {           // ~1 second at 20ms
 
     // PANIC
     strcpy(buf, "[PANIC] ");
-    strcat(buf, panic_mode ? "TRIGGERED" : "NOT TRIGGERED");
-    draw_text(&g_disp, g_fx, x, y_live_panic, buf, panic_mode ? RGB_RED : RGB_GREEN);
+    strcat(buf, g_ctl.panic_mode ? "TRIGGERED" : "NOT TRIGGERED");
+    draw_text(&g_disp, g_fx, x, y_live_panic, buf, g_ctl.panic_mode ? RGB_RED : RGB_GREEN);
 
     // TIME (and CALM marker)
     int elapsed_ms = g_calm_reached ? g_calm_elapsed_ms : (int)(now_msec() - g_algo_start_ms);
@@ -1442,24 +1437,9 @@ for (int i = 0; i < 50; i++) {           // ~1 second at 20ms
     strcat(buf, g_calm_reached ? " (CALM)" : "");
     draw_text(&g_disp, g_fx, x, y_live_time, buf, g_calm_reached ? RGB_GREEN : RGB_WHITE);
 
-    // Real-life reaction delay:
-    // If crying-based regime: short delay (4 s)
-    // If heartbeat-based regime: long delay (10 s) to respect TAU
-    int delay_ms;
-    if (hit_wall)
-    {
-      delay_ms = CONVERGENCE_DELAY;
-    }
-    else if (is_crying_activated)
-    {
-      delay_ms = CRYING_DELAY;
-    }
-    else
-    {
-      delay_ms = HEARTBEAT_DELAY;
-    }
-
-    sleep_msec(delay_ms);
+    // Real-life reaction delay is the step cadence above (controller_period_ms); in between keep
+    // sampling the vitals for the TAU estimate
+    sleep_msec(TAU_SAMPLE_MS);
     
 
 
@@ -0,0 +1,59 @@
+// plant.h — the baby as the simulator models it, small enough to copy around.
+// sim.c moves its plant with plant_classify, controller.c (MPC mode) forks plant_snapshot hypotheses
+// and rolls candidate moves out on them. Header only, no heap, no globals.
+
+#ifndef PLANT_H
+#define PLANT_H
+
+// what the plant does when the cradle goes from a cell with band [oldLo, oldHi] at stress S to a cell
+// with band [newLo, newHi]
+enum
+{
+  MOVE_INSIDE,      // S already inside the new band: converge
+  MOVE_PANIC_JUMP,  // purely softer into a band that does not touch the old one
+  MOVE_PANIC_BLOCK, // purely harder into a band that does not touch the old one
+  MOVE_MIXED,       // no overlap but soft on one axis, hard on the other: clamp + converge
+  MOVE_OVERLAP      // bands overlap, S outside the new one: clamp + converge
+};
+
+static inline int plant_classify(int oldA, int oldF, double oldLo, double oldHi, double S,
+                                 int newA, int newF, double newLo, double newHi)
+{
+  int softer = (newA < oldA) || (newF < oldF);
+  int harder = (newA > oldA) || (newF > oldF);
+
+  if (S >= newLo && S <= newHi)
+    return MOVE_INSIDE;
+  if (oldHi < newLo || oldLo > newHi)
+  {
+    if (softer && !harder)
+      return MOVE_PANIC_JUMP;
+    if (harder && !softer)
+      return MOVE_PANIC_BLOCK;
+    return MOVE_MIXED;
+  }
+  return MOVE_OVERLAP;
+}
+
+// One plant between moves: always settled at Sopt of some K level (the cell's K once converged,
+// 9 after a panic), so this is all the state a move needs. Plain data: fork it with =.
+typedef struct plant_snapshot
+{
+  unsigned char K[25];            // K per cell, index a * 5 + f
+  float Sopt[10], lo[10], hi[10]; // per K level 1-9
+  unsigned char cell;             // current cell
+  unsigned char level;            // S = Sopt[level]
+} plant_snapshot;
+
+// command cell 'to' and let the plant settle. returns the MOVE_* kind
+static inline int plant_move(plant_snapshot *p, int to)
+{
+  int from = p->cell, oldK = p->K[from], newK = p->K[to];
+  int kind = plant_classify(from / 5, from % 5, p->lo[oldK], p->hi[oldK], p->Sopt[p->level],
+                            to / 5, to % 5, p->lo[newK], p->hi[newK]);
+  p->cell = (unsigned char)to;
+  p->level = (kind == MOVE_PANIC_JUMP || kind == MOVE_PANIC_BLOCK) ? 9 : (unsigned char)newK;
+  return kind;
+}
+
+#endif
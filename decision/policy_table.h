@@ -0,0 +1,69 @@
+// policy_table.h — GENERATED by ../sim/sim -G 5000 (make -C ../sim policy), do not edit.
+// CTRL_MODE_TABLE policy (controller.c), indexed by POLICY_INDEX(cell, probe, trend, tried),
+// actions POLICY_*. One line per anchor cell. Tuned from policy_default on simulated babies:
+//   default, tuned on seeds 1..5000: calm 100.0%, mean 104.3 s, p95 133.2 s, 0.00 panics/run, cost 104.3
+//   table, tuned on   seeds 1..5000: calm 100.0%, mean 96.1 s, p95 123.5 s, 0.12 panics/run, cost 99.8
+//   default, held out seeds 5001..10000: calm 100.0%, mean 104.0 s, p95 133.2 s, 0.00 panics/run, cost 104.0
+//   table, held out   seeds 5001..10000: calm 100.0%, mean 95.8 s, p95 123.2 s, 0.12 panics/run, cost 99.3
+//   default, fresh    seeds 10001..15000: calm 100.0%, mean 104.3 s, p95 133.2 s, 0.00 panics/run, cost 104.3
+//   table, fresh      seeds 10001..15000: calm 100.0%, mean 96.5 s, p95 123.5 s, 0.12 panics/run, cost 100.2
+
+#ifndef POLICY_TABLE_H
+#define POLICY_TABLE_H
+
+#define POLICY_TABLE_STATES 1200
+
+static const unsigned char policy_table[POLICY_TABLE_STATES] = {
+    // A1 F1
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A1 F2
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A1 F3
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A1 F4
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A1 F5
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A2 F1
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A2 F2
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A2 F3
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A2 F4
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A2 F5
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A3 F1
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A3 F2
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A3 F3
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A3 F4
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A3 F5
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A4 F1
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A4 F2
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A4 F3
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A4 F4
+    2, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A4 F5
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A5 F1
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A5 F2
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A5 F3
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A5 F4
+    2, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    // A5 F5
+    1, 2, 1, 3, 1, 2, 1, 3, 1, 2, 1, 3, 2, 2, 2, 2, 2, 3, 2, 2, 4, 4, 4, 4, 1, 4, 1, 4, 1, 4, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 2, 4, 4, 4, 4, 4, 4,
+};
+
+#endif
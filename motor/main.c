@@ -13,6 +13,7 @@
 #include <signal.h>
 #include <buttons.h> // <-- adjust include if needed
 #include <unistd.h>
+#include <pthread.h>
 
 #define UART_CH UART0
 #define MSTR 0
@@ -139,98 +140,269 @@ static void draw_frame_for_line(display_t *d, int x, int y, int fh, uint16_t col
 }
 
 // --- UART helpers ---
-static int timeouted_byte(int ms)
+// everything the RX FIFO holds right now, up to max bytes: never waits
+static int uart_read_burst(uint8_t buf[], int max)
 {
-  int waited = 0;
-  while (waited < ms)
+  int n = 0;
+  while (n < max && uart_has_data(UART_CH))
+    buf[n++] = (uint8_t)uart_recv(UART_CH);
+  return n;
+}
+
+// Nothing to read: spin for RX_SPIN empty polls (the next byte of a frame is about 87 us away at
+// 115200 baud), then sleep, twice as long each time up to RX_SLEEP_MAX_US. *sleep_us = 0 restarts it.
+#define RX_SPIN 256
+#define RX_SLEEP_MIN_US 50
+#define RX_SLEEP_MAX_US 1000 // 11.5 byte times at 115200 baud: the 16-byte FIFO cannot overflow
+
+static void rx_backoff(int *idle, unsigned *sleep_us)
+{
+  if (++*idle <= RX_SPIN)
+    return;
+  *sleep_us = (*sleep_us == 0) ? RX_SLEEP_MIN_US : (*sleep_us * 2 > RX_SLEEP_MAX_US) ? RX_SLEEP_MAX_US : *sleep_us * 2;
+  struct timespec ts = {0, (long)*sleep_us * 1000L};
+  nanosleep(&ts, NULL);
+}
+
+static unsigned rx_now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned)(ts.tv_sec * 1000u + ts.tv_nsec / 1000000);
+}
+
+// rx_thread forwards frames on the same wire: one sender at a time, so frames never interleave
+static pthread_mutex_t g_tx_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// [DST][SRC][LEN][PAYLOAD]
+static void send_message_impl(uint8_t dst, uint8_t src, const uint8_t payload[], uint8_t len)
+{
+  pthread_mutex_lock(&g_tx_lock);
+  uart_send(UART_CH, dst);
+  uart_send(UART_CH, src);
+  uart_send(UART_CH, len);
+  for (int i = 0; i < len; i++)
   {
-    if (uart_has_data(UART_CH))
-    {
-      return (int)uart_recv(UART_CH);
-    }
-    sleep_msec(1);
-    waited += 1;
+    uart_send(UART_CH, payload[i]);
   }
-  return -1;
+  pthread_mutex_unlock(&g_tx_lock);
 }
 
-static int receive_byte(void) { return timeouted_byte(TIMEOUT); }
+#define send_message(dst, src, payload) \
+  send_message_impl(dst, src, payload, (uint8_t)sizeof(payload))
 
 // --- parsed frame globals (filled by receive_message) ---
 static uint8_t g_src = 0;
 static uint8_t g_len = 0;
 static uint8_t g_payload[MAX_PAY];
 
-// UPDATED: Now non-blocking. Returns -1 immediately if no data.
-static int receive_message(void)
+// -------- UART receive thread ----------
+// rx_thread owns the RX side: it drains the FIFO in bursts and assembles frames as they come in,
+// no matter what the main loop is busy with. Frames for other nodes go straight back out on the
+// ring (rx_byte), frames for this node land in a lock-free single-producer / single-consumer ring
+// that receive_message pops without blocking.
+
+#define RX_FRAMES 16 // ring slots, power of two
+
+typedef struct
 {
-  if (!uart_has_data(UART_CH))
+  uint8_t src, len;
+  uint8_t payload[MAX_PAY];
+} rx_frame;
+
+static rx_frame g_rx_ring[RX_FRAMES];
+static unsigned g_rx_head = 0; // next slot rx_thread fills, only rx_thread writes it
+static unsigned g_rx_tail = 0; // next slot receive_message pops, only the main loop writes it
+
+// queue a frame for the main loop (payload clamped to MAX_PAY like before)
+static void rx_push(uint8_t src, const uint8_t payload[], int len)
+{
+  unsigned head = g_rx_head;
+  if (head - __atomic_load_n(&g_rx_tail, __ATOMIC_ACQUIRE) == RX_FRAMES)
+    return; // main loop this far behind: drop it, the master asks again
+
+  rx_frame *f = &g_rx_ring[head % RX_FRAMES];
+  f->src = src;
+  f->len = (uint8_t)((len > MAX_PAY) ? MAX_PAY : len);
+  memcpy(f->payload, payload, f->len);
+  __atomic_store_n(&g_rx_head, head + 1, __ATOMIC_RELEASE); // publish only once the slot is filled
+}
+
+// Frame assembler: rebuilds [DST][SRC][LEN][PAYLOAD] from the bursts, however the frames are cut up
+// between them. A frame for another node is forwarded cut-through, every byte going back out as it
+// is assembled, never buffered here: a hop costs a byte time, not a frame. TX stays locked from its
+// DST to its last byte, so an upstream stall must not hold it for long (rx_stalled, rx_abort).
+// RX_SKIP: the tail of a frame cut off while it still came in, dropped until the line is quiet.
+enum { RX_DST, RX_SRC, RX_LEN, RX_PAYLOAD, RX_SKIP };
+
+#define FWD_STALL_MS 5  // a forwarded frame that gets no byte for this long is cut off
+#define FWD_FRAME_MS 30 // and so is one still not through after this long (258 bytes: 22 ms at 115200)
+#define RX_FILL 0xFF    // pads a cut-off frame. No frame ends in it otherwise, so receivers drop those
+
+typedef struct
+{
+  int state;   // RX_*: the byte expected next
+  int forward; // this frame is for another node
+  uint8_t src, len;
+  int n;       // payload bytes so far
+  uint8_t payload[255];
+  unsigned last_ms;  // when the frame last got a byte
+  unsigned first_ms; // when its DST came in
+} rx_assembler;
+
+static void rx_byte(rx_assembler *a, uint8_t b)
+{
+  if (a->state == RX_SKIP)
+    return;
+  if (a->state == RX_DST)
   {
-    return -1;
+    a->forward = (b != MTR);
+    a->first_ms = rx_now_ms();
+    if (a->forward)
+      pthread_mutex_lock(&g_tx_lock);
   }
+  if (a->forward)
+    uart_send(UART_CH, b);
 
-  int b = receive_byte(); // DST
-  if (b < 0)
-    return -1;
-  uint8_t dst = (uint8_t)b;
+  switch (a->state)
+  {
+  case RX_DST:
+    a->state = RX_SRC;
+    return;
+  case RX_SRC:
+    a->src = b;
+    a->state = RX_LEN;
+    return;
+  case RX_LEN:
+    a->len = b;
+    a->n = 0;
+    a->state = RX_PAYLOAD;
+    break;
+  default:
+    if (!a->forward)
+      a->payload[a->n] = b;
+    a->n++;
+    break;
+  }
 
-  b = receive_byte(); // SRC
-  if (b < 0)
-    return -1;
-  uint8_t src = (uint8_t)b;
+  if (a->n == a->len) // complete
+  {
+    if (a->forward)
+      pthread_mutex_unlock(&g_tx_lock);
+    else if (a->n == 0 || a->payload[a->n - 1] != RX_FILL) // not one a node had to cut off
+      rx_push(a->src, a->payload, a->n);
+    a->state = RX_DST;
+  }
+}
 
-  b = receive_byte(); // LEN
-  if (b < 0)
-    return -1;
-  uint8_t len = (uint8_t)b;
+// a frame for this node gets TIMEOUT between bytes. A forwarded one holds TX meanwhile, so it gets
+// FWD_STALL_MS between bytes and FWD_FRAME_MS in all. A skipped tail ends after FWD_STALL_MS of quiet
+static int rx_stalled(const rx_assembler *a, unsigned now)
+{
+  if (a->state == RX_DST)
+    return 0;
+  if (a->state == RX_SKIP)
+    return now - a->last_ms >= FWD_STALL_MS;
+  if (a->forward)
+    return now - a->last_ms >= FWD_STALL_MS || now - a->first_ms >= FWD_FRAME_MS;
+  return now - a->last_ms >= TIMEOUT;
+}
 
-  // Forward if not for me
-  if (dst != MTR)
+// the frame stalled: drop it. Part of a forwarded one is already out, and TX cannot be let go with
+// the next node mid-frame, or this node's own next frame would become its tail: it gets an empty
+// frame if LEN is not out yet, else the payload padded to LEN with RX_FILL, which it drops. If the
+// frame was cut off at FWD_FRAME_MS while its bytes still come in, the rest of them is skipped: read
+// as DST, SRC and LEN they would go out as frames of junk.
+static void rx_abort(rx_assembler *a, unsigned now)
+{
+  if (a->state == RX_SKIP) // quiet again, the next byte starts a frame
   {
-    uart_send(UART_CH, dst);
-    uart_send(UART_CH, src);
-    uart_send(UART_CH, len);
-    for (int i = 0; i < len; i++)
+    a->state = RX_DST;
+    return;
+  }
+  if (a->forward)
+  {
+    if (a->state == RX_SRC)
+      uart_send(UART_CH, RX_FILL); // no node has that address
+    if (a->state != RX_PAYLOAD)
     {
-      int pb = receive_byte();
-      if (pb < 0)
-        return -2;
-      uart_send(UART_CH, (uint8_t)pb);
+      uart_send(UART_CH, 0); // LEN
+      a->len = 0;
+      a->n = 0;
     }
-    return 0;
+    for (; a->n < a->len; a->n++)
+      uart_send(UART_CH, RX_FILL);
+    pthread_mutex_unlock(&g_tx_lock);
   }
+  a->state = (now - a->last_ms < FWD_STALL_MS) ? RX_SKIP : RX_DST;
+}
 
-  // Receive for me
-  if (len > MAX_PAY)
-    len = MAX_PAY;
+#define RX_BURST 64 // bytes per read, more than the FIFO holds
 
-  for (int i = 0; i < len; i++)
+static void *rx_thread(void *arg)
+{
+  (void)arg;
+  rx_assembler a;
+  memset(&a, 0, sizeof(a));
+  uint8_t buf[RX_BURST];
+  int idle = 0;
+  unsigned sleep_us = 0;
+
+  while (1)
   {
-    b = receive_byte();
-    if (b < 0)
-      return -3;
-    g_payload[i] = (uint8_t)b;
+    int n = uart_read_burst(buf, RX_BURST);
+    if (n > 0)
+    {
+      for (int i = 0; i < n; i++)
+        rx_byte(&a, buf[i]);
+      a.last_ms = rx_now_ms();
+      idle = 0;
+      sleep_us = 0;
+    }
+    unsigned now = rx_now_ms();
+    if (rx_stalled(&a, now)) // checked after a burst too: a trickle must not hold TX either
+      rx_abort(&a, now);
+    if (n > 0)
+      continue;
+    rx_backoff(&idle, &sleep_us);
   }
-
-  g_src = src;
-  g_len = len;
-  return g_len;
+  return NULL;
 }
 
-// [DST][SRC][LEN][PAYLOAD]
-static void send_message_impl(uint8_t dst, uint8_t src, const uint8_t payload[], uint8_t len)
+// start rx_thread, once the UART is set up
+static void rx_start(void)
 {
-  uart_send(UART_CH, dst);
-  uart_send(UART_CH, src);
-  uart_send(UART_CH, len);
-  for (int i = 0; i < len; i++)
+  pthread_t t;
+  if (pthread_create(&t, NULL, rx_thread, NULL) != 0)
   {
-    uart_send(UART_CH, payload[i]);
+    perror("rx thread");
+    exit(1);
   }
+  pthread_detach(t);
 }
 
-#define send_message(dst, src, payload) \
-  send_message_impl(dst, src, payload, (uint8_t)sizeof(payload))
+// take the oldest frame for this node into g_src, g_len, g_payload. Never blocks:
+// returns its length, or -1 if there is none
+static int receive_message(void)
+{
+  unsigned tail = g_rx_tail;
+  if (tail == __atomic_load_n(&g_rx_head, __ATOMIC_ACQUIRE))
+    return -1;
+
+  const rx_frame *f = &g_rx_ring[tail % RX_FRAMES];
+  g_src = f->src;
+  g_len = f->len;
+  memcpy(g_payload, f->payload, f->len);
+  __atomic_store_n(&g_rx_tail, tail + 1, __ATOMIC_RELEASE); // slot free again
+  return (int)g_len;
+}
+
+// the sequence number the master's request ended with: echo it as the last byte of the reply, so the
+// master can match the reply to its request (0 from a master that sends none)
+static uint8_t req_seq(void)
+{
+  return (g_len >= 2) ? g_payload[g_len - 1] : 0;
+}
 
 // region 1..5 -> midpoint %
 static int region_mid_duty(int r)
@@ -363,6 +535,7 @@ int main(void)
   // UART pins (do NOT reuse these for PWM)
   switchbox_set_pin(IO_AR0, SWB_UART0_RX);
   switchbox_set_pin(IO_AR1, SWB_UART0_TX);
+  rx_start(); // from here on frames are read (and passed on) whatever the main loop does
 
   // PWM outputs – map to cradle driver pins
   switchbox_set_pin(AMP_PWM_PIN, AMP_PWM_CFG);
@@ -426,7 +599,7 @@ int main(void)
       uint8_t cmd = g_payload[0];
       if (cmd == 'A')
       {
-        uint8_t rsp[] = {'A'};
+        uint8_t rsp[] = {'A', req_seq()};
         send_message(MSTR, MTR, rsp);
       }
       else if (cmd == 'M' && g_len >= 3)
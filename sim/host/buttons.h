@@ -0,0 +1,2 @@
+// buttons.h — host stand-in: the button calls are declared in libpynq.h
+#include <libpynq.h>
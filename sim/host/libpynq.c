@@ -0,0 +1,58 @@
+// libpynq.c — the host stand-in's no-op peripherals (see libpynq.h). Fonts report an 8x16 glyph so
+// the text layout code runs as on the board.
+
+#include <unistd.h>
+
+#include <libpynq.h>
+
+void pynq_init(void) {}
+void pynq_destroy(void) {}
+void sleep_msec(int ms) { usleep((useconds_t)ms * 1000); }
+
+void display_init(display_t *display) { display->flip = 0; }
+void display_destroy(display_t *display) { (void)display; }
+void display_set_flip(display_t *display, int xflip, int yflip) { display->flip = xflip | (yflip << 1); }
+void displayFillScreen(display_t *display, uint16_t color) { (void)display, (void)color; }
+void displayDrawFillRect(display_t *display, int x1, int y1, int x2, int y2, uint16_t color)
+{
+    (void)display, (void)x1, (void)y1, (void)x2, (void)y2, (void)color;
+}
+void displayDrawRect(display_t *display, int x1, int y1, int x2, int y2, uint16_t color)
+{
+    (void)display, (void)x1, (void)y1, (void)x2, (void)y2, (void)color;
+}
+void displayDrawString(display_t *display, FontxFile *fx, int x, int y, uint8_t *ascii, uint16_t color)
+{
+    (void)display, (void)fx, (void)x, (void)y, (void)ascii, (void)color;
+}
+void displaySetFontDirection(display_t *display, int dir) { (void)display, (void)dir; }
+void InitFontx(FontxFile *fx, const char *f0, const char *f1) { fx->valid = 1, (void)f0, (void)f1; }
+int GetFontx(FontxFile *fx, uint8_t ascii, uint8_t *pGlyph, uint8_t *pw, uint8_t *ph)
+{
+    (void)fx, (void)ascii, (void)pGlyph;
+    *pw = 8;
+    *ph = 16;
+    return 1;
+}
+
+void buttons_init(void) {}
+void buttons_destroy(void) {}
+int get_button_state(int button) { return (void)button, 0; }
+void switches_init(void) {}
+void switches_destroy(void) {}
+int get_switch_state(int sw) { return (void)sw, 0; }
+void switchbox_set_pin(int pin, int channel) { (void)pin, (void)channel; }
+
+void adc_init(void) {}
+void adc_destroy(void) {}
+float adc_read_channel(int channel) { return (void)channel, 0.0f; }
+void gpio_init(void) {}
+void gpio_destroy(void) {}
+void gpio_set_direction(int pin, int direction) { (void)pin, (void)direction; }
+void pwm_init(int pwm, uint32_t period) { (void)pwm, (void)period; }
+void pwm_destroy(int pwm) { (void)pwm; }
+void pwm_set_period(int pwm, uint32_t period) { (void)pwm, (void)period; }
+void pwm_set_duty_cycle(int pwm, uint32_t duty) { (void)pwm, (void)duty; }
+
+void uart_init(int uart) { (void)uart; }
+void uart_reset_fifos(int uart) { (void)uart; }
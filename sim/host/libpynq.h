@@ -0,0 +1,87 @@
+// libpynq.h — host stand-in for the PYNQ library, just enough to build the node main.c files on a PC
+// (make rx-check). The display, buttons, ADC, GPIO and PWM do nothing (libpynq.c). The UART is the
+// test's: uart_send, uart_recv and uart_has_data are left to whoever links these in (rxcheck.c).
+
+#ifndef LIBPYNQ_HOST_H
+#define LIBPYNQ_HOST_H
+
+#include <stdint.h>
+
+#define DISPLAY_WIDTH 240
+#define DISPLAY_HEIGHT 240
+#define RGB_BLACK 0x0000
+#define RGB_WHITE 0xffff
+#define RGB_RED 0xf800
+#define RGB_GREEN 0x07e0
+#define RGB_BLUE 0x001f
+#define RGB_YELLOW 0xffe0
+#define RGB_CYAN 0x07ff
+#define TEXT_DIRECTION0 0
+#define FontxGlyphBufSize (32 * 32 / 8)
+
+#define UART0 0
+#define ADC0 0
+#define PWM0 0
+#define PWM1 1
+#define IO_AR0 0
+#define IO_AR1 1
+#define IO_AR2 2
+#define IO_AR3 3
+#define GPIO_DIR_INPUT 0
+#define SWB_GPIO 0
+#define SWB_UART0_RX 1
+#define SWB_UART0_TX 2
+#define SWB_PWM0 3
+#define SWB_PWM1 4
+
+typedef struct
+{
+    int flip;
+} display_t;
+
+typedef struct
+{
+    int valid;
+} FontxFile;
+
+void pynq_init(void);
+void pynq_destroy(void);
+void sleep_msec(int ms);
+
+void display_init(display_t *display);
+void display_destroy(display_t *display);
+void display_set_flip(display_t *display, int xflip, int yflip);
+void displayFillScreen(display_t *display, uint16_t color);
+void displayDrawFillRect(display_t *display, int x1, int y1, int x2, int y2, uint16_t color);
+void displayDrawRect(display_t *display, int x1, int y1, int x2, int y2, uint16_t color);
+void displayDrawString(display_t *display, FontxFile *fx, int x, int y, uint8_t *ascii, uint16_t color);
+void displaySetFontDirection(display_t *display, int dir);
+void InitFontx(FontxFile *fx, const char *f0, const char *f1);
+int GetFontx(FontxFile *fx, uint8_t ascii, uint8_t *pGlyph, uint8_t *pw, uint8_t *ph);
+
+void buttons_init(void);
+void buttons_destroy(void);
+int get_button_state(int button);
+void switches_init(void);
+void switches_destroy(void);
+int get_switch_state(int sw);
+void switchbox_set_pin(int pin, int channel);
+
+void adc_init(void);
+void adc_destroy(void);
+float adc_read_channel(int channel);
+void gpio_init(void);
+void gpio_destroy(void);
+void gpio_set_direction(int pin, int direction);
+void pwm_init(int pwm, uint32_t period);
+void pwm_destroy(int pwm);
+void pwm_set_period(int pwm, uint32_t period);
+void pwm_set_duty_cycle(int pwm, uint32_t duty);
+
+void uart_init(int uart);
+void uart_reset_fifos(int uart);
+void uart_send(int uart, uint8_t data);
+uint8_t uart_recv(int uart);
+int uart_has_data(int uart);
+
+#endif
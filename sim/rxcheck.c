@@ -0,0 +1,557 @@
+// rxcheck.c — host check of a node's ring receive path (make rx-check)
+// Builds one node's own main.c (-DRX_NODE_heartbeat, _crying, _motor or _decision) against the host
+// libpynq stand-in and a fake UART, starts its rx_thread and feeds it bytes: frames cut up or run
+// together, frames for other nodes, more frames than the SPSC ring holds, and an upstream that stalls
+// mid-frame. Checks what receive_message hands out and what goes back out on the ring, and on the
+// master how replies are matched to its requests. Exit 1 on any failure.
+
+#define main node_main
+#if defined(RX_NODE_heartbeat)
+#include "../heartbeat/main.c"
+#define ME HRTBT
+#define RX_NODE_NAME "heartbeat"
+#define node_send(dst, src, p, n) (send_message)(dst, src, p, n)
+#elif defined(RX_NODE_crying)
+#include "../crying/main.c"
+#define ME CRY
+#define RX_NODE_NAME "crying"
+#define node_send(dst, src, p, n) send_message(dst, src, p, n)
+#elif defined(RX_NODE_motor)
+#include "../motor/main.c"
+#define ME MTR
+#define RX_NODE_NAME "motor"
+#define node_send(dst, src, p, n) send_message_impl(dst, src, p, n)
+#elif defined(RX_NODE_decision)
+#include "../decision/main.c"
+#define ME MSTR
+#define RX_NODE_NAME "decision"
+#define node_send(dst, src, p, n) send_message_raw(dst, src, p, n)
+#define RX_MASTER // does not forward: frames for other nodes are dropped
+#else
+#error "build with -DRX_NODE_<heartbeat|crying|motor|decision>"
+#endif
+#undef main
+
+#define PEER ((ME == MSTR) ? HRTBT : MSTR) // who this node's frames come from
+#define OTHER ((ME == MTR) ? CRY : MTR)    // a node the frames this node passes on are for
+
+// FAKE UART
+// RX: bytes the test feeds, read by rx_thread. TX: everything the node sends, forwarded or its own.
+static uint8_t g_in[1 << 12];
+static unsigned g_in_n, g_in_r; // g_in_n written by the test, g_in_r by rx_thread
+
+static pthread_mutex_t g_out_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t g_out[1 << 12];
+static int g_out_n;
+
+int uart_has_data(int uart)
+{
+    (void)uart;
+    return g_in_r != __atomic_load_n(&g_in_n, __ATOMIC_ACQUIRE);
+}
+
+uint8_t uart_recv(int uart)
+{
+    (void)uart;
+    return g_in[g_in_r++ % sizeof(g_in)];
+}
+
+void uart_send(int uart, uint8_t b)
+{
+    (void)uart;
+    pthread_mutex_lock(&g_out_lock);
+    if (g_out_n < (int)sizeof(g_out))
+        g_out[g_out_n++] = b;
+    pthread_mutex_unlock(&g_out_lock);
+}
+
+static pthread_mutex_t g_in_lock = PTHREAD_MUTEX_INITIALIZER; // the master's fake sensor nodes feed too
+
+static void feed(const uint8_t *b, int n)
+{
+    pthread_mutex_lock(&g_in_lock);
+    unsigned in_n = g_in_n;
+    for (int i = 0; i < n; i++)
+        g_in[(in_n + i) % sizeof(g_in)] = b[i];
+    __atomic_store_n(&g_in_n, in_n + (unsigned)n, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_in_lock);
+}
+
+static int out_n(void)
+{
+    pthread_mutex_lock(&g_out_lock);
+    int n = g_out_n;
+    pthread_mutex_unlock(&g_out_lock);
+    return n;
+}
+
+static void out_clear(void)
+{
+    pthread_mutex_lock(&g_out_lock);
+    g_out_n = 0;
+    pthread_mutex_unlock(&g_out_lock);
+}
+
+// let rx_thread catch up: it sleeps at most 1 ms between polls
+static void settle(void)
+{
+    usleep(20 * 1000);
+}
+
+// CHECKS
+
+static int g_failed = 0;
+
+#define CHECK(cond, ...)                    \
+    do                                      \
+    {                                       \
+        if (!(cond))                        \
+        {                                   \
+            printf("  FAIL: " __VA_ARGS__); \
+            printf("\n");                   \
+            g_failed++;                     \
+        }                                   \
+    } while (0)
+
+static int out_is(const uint8_t *want, int n)
+{
+    pthread_mutex_lock(&g_out_lock);
+    int same = (g_out_n == n && !memcmp(g_out, want, (size_t)n));
+    pthread_mutex_unlock(&g_out_lock);
+    return same;
+}
+
+// pop every queued frame for this node: their count, the last payload byte of each in last[]
+static int drain(uint8_t last[], int max)
+{
+    int k = 0, n;
+    while ((n = receive_message()) >= 0)
+    {
+        if (k < max)
+            last[k] = n ? g_payload[n - 1] : 0;
+        k++;
+    }
+    return k;
+}
+
+// one frame for this node, byte by byte with a gap, then three in a single burst
+static void check_split(void)
+{
+    printf("frames cut up and run together\n");
+    uint8_t f[] = {ME, PEER, 2, 'A', 7};
+    for (int i = 0; i < (int)sizeof(f); i++)
+    {
+        feed(&f[i], 1);
+        usleep(1000);
+    }
+    settle();
+    int n = receive_message();
+    CHECK(n == 2 && g_src == PEER && g_payload[0] == 'A' && g_payload[1] == 7, "byte-wise frame: len %d", n);
+
+    uint8_t three[] = {ME, PEER, 2, 'B', 1, ME, PEER, 1, 'C', ME, PEER, 2, 'D', 3};
+    feed(three, (int)sizeof(three));
+    settle();
+    uint8_t last[4];
+    int k = drain(last, 4);
+    CHECK(k == 3 && last[0] == 1 && last[1] == 'C' && last[2] == 3, "burst of three: got %d frames", k);
+    CHECK(out_n() == 0, "frames for this node went out on the ring (%d bytes)", out_n());
+}
+
+// frames for another node around one for this node: passed on byte for byte, or dropped by the master
+static void check_forward(void)
+{
+    printf("frames for other nodes\n");
+    out_clear();
+    uint8_t a[] = {OTHER, PEER, 3, 'M', 40, 60};
+    uint8_t b[] = {ME, PEER, 1, 'A'};
+    uint8_t c[] = {OTHER, ME == HRTBT ? CRY : HRTBT, 2, 'P', 9};
+    feed(a, (int)sizeof(a));
+    feed(b, (int)sizeof(b));
+    feed(c, (int)sizeof(c));
+    settle();
+    uint8_t last[4];
+    CHECK(drain(last, 4) == 1 && last[0] == 'A', "the frame for this node did not come through alone");
+#ifdef RX_MASTER
+    uint8_t none[1];
+    CHECK(out_is(none, 0), "the master sent %d bytes", out_n());
+#else
+    uint8_t want[sizeof(a) + sizeof(c)];
+    memcpy(want, a, sizeof(a));
+    memcpy(want + sizeof(a), c, sizeof(c));
+    CHECK(out_is(want, (int)sizeof(want)), "forwarded %d bytes, not the two frames unchanged", out_n());
+#endif
+}
+
+// more frames than the ring holds while the main loop does not pop: the oldest RX_FRAMES stay
+static void check_full(void)
+{
+    printf("ring full\n");
+    for (int i = 0; i < RX_FRAMES + 4; i++)
+    {
+        uint8_t f[] = {ME, PEER, 2, 'A', (uint8_t)i};
+        feed(f, (int)sizeof(f));
+    }
+    settle();
+    uint8_t last[RX_FRAMES + 4];
+    int k = drain(last, RX_FRAMES + 4);
+    int in_order = 1;
+    for (int i = 0; i < k && i < RX_FRAMES; i++)
+        in_order &= (last[i] == i);
+    CHECK(k == RX_FRAMES && in_order, "got %d frames, want the first %d", k, RX_FRAMES);
+
+    uint8_t f[] = {ME, PEER, 1, 'Z'};
+    feed(f, (int)sizeof(f));
+    settle();
+    CHECK(drain(last, 1) == 1 && last[0] == 'Z', "ring did not take frames again once popped");
+}
+
+// a frame a node had to cut off ends in RX_FILL: never handed out
+static void check_cut_off(void)
+{
+    printf("cut-off frame for this node\n");
+    uint8_t f[] = {ME, PEER, 3, 'H', RX_FILL, RX_FILL};
+    feed(f, (int)sizeof(f));
+    settle();
+    uint8_t last[1];
+    CHECK(drain(last, 1) == 0, "a frame padded with RX_FILL was handed out");
+}
+
+#ifndef RX_MASTER
+// upstream stalls in a frame this node passes on: the frame is finished for the next node (empty
+// before LEN, padded after), and TX is free again after FWD_STALL_MS, not TIMEOUT. A frame cut off
+// while it still trickles in has its tail skipped, not read as new frames
+static void check_stall(void)
+{
+    printf("upstream stalls mid-frame\n");
+    uint8_t head[] = {OTHER, PEER, 3, 'x'};
+    out_clear();
+    feed(head, (int)sizeof(head));
+    usleep(2000);
+    unsigned t0 = rx_now_ms();
+    uint8_t mine[] = {'A', 5};
+    node_send(MSTR, ME, mine, 2); // waits for TX
+    unsigned held = rx_now_ms() - t0;
+    uint8_t want[] = {OTHER, PEER, 3, 'x', RX_FILL, RX_FILL, MSTR, ME, 2, 'A', 5};
+    CHECK(out_is(want, (int)sizeof(want)), "padded frame then own reply not on the ring as expected (%d bytes)",
+          out_n());
+    CHECK(held <= FWD_STALL_MS + 5, "own reply waited %u ms behind the stalled frame", held);
+
+    uint8_t dst_only[] = {OTHER};
+    out_clear();
+    feed(dst_only, 1);
+    settle();
+    uint8_t want_empty[] = {OTHER, RX_FILL, 0};
+    CHECK(out_is(want_empty, 3), "a frame cut before SRC did not go out empty (%d bytes)", out_n());
+
+    uint8_t no_len[] = {OTHER, PEER};
+    out_clear();
+    feed(no_len, 2);
+    settle();
+    uint8_t want_no_len[] = {OTHER, PEER, 0};
+    CHECK(out_is(want_no_len, 3), "a frame cut before LEN did not go out empty (%d bytes)", out_n());
+
+    // a trickle just under FWD_STALL_MS: cut off at FWD_FRAME_MS, padded to its 200 bytes
+    uint8_t slow[] = {OTHER, PEER, 200};
+    out_clear();
+    feed(slow, 3);
+    t0 = rx_now_ms();
+    uint8_t b = 'y';
+    while (out_n() < 3 + 200 && rx_now_ms() - t0 < 500)
+    {
+        feed(&b, 1);
+        usleep((FWD_STALL_MS - 2) * 1000);
+    }
+    held = rx_now_ms() - t0;
+    // the rest of it keeps trickling in, looking like frames: skipped until the line is quiet
+    uint8_t tail[] = {OTHER, PEER, 1, 'j', ME, PEER, 1, 'J'};
+    for (int i = 0; i < (int)sizeof(tail); i++)
+    {
+        feed(&tail[i], 1);
+        usleep((FWD_STALL_MS - 3) * 1000);
+    }
+    settle();
+    CHECK(out_n() >= 3 + 200, "trickled frame never finished (%d bytes out)", out_n());
+    CHECK(held <= FWD_FRAME_MS + 10, "trickled frame held TX %u ms", held);
+    uint8_t last[1];
+    CHECK(out_n() <= 3 + 200, "the tail of the cut-off frame went out as %d bytes", out_n() - (3 + 200));
+    CHECK(drain(last, 1) == 0, "the tail of the cut-off frame was handed out as a frame");
+
+    uint8_t next[] = {OTHER, PEER, 1, 'k'};
+    out_clear();
+    feed(next, (int)sizeof(next));
+    settle();
+    CHECK(out_is(next, (int)sizeof(next)), "the frame after the skipped tail did not go out unchanged (%d bytes)",
+          out_n());
+}
+#endif
+
+#ifdef RX_MASTER
+// REQUESTS
+// The master's request / reply matching (req_send_args, req_poll, req_wait, req_check), with the
+// sensor nodes' replies fed in by hand. A reply is [cmd, value, seq], seq echoing the request's.
+
+#define REQ_TEST_MS 100 // timeout for requests the test answers itself, long enough for settle()
+
+// a reply from src, as the node would send it back to the master
+static void reply(uint8_t src, uint8_t cmd, uint8_t value, uint8_t seq)
+{
+    uint8_t f[] = {MSTR, src, 3, cmd, value, seq};
+    feed(f, (int)sizeof(f));
+}
+
+// replies come back in another order than the requests went out: each finds its own request
+static void check_req_order(void)
+{
+    printf("replies out of order\n");
+    out_clear();
+    int h = req_send(HRTBT, 'H', REQ_TEST_MS);
+    int c1 = req_send(CRY, 'C', REQ_TEST_MS);
+    int c2 = req_send(CRY, 'C', REQ_TEST_MS);
+    CHECK(h >= 0 && c1 >= 0 && c2 >= 0 && g_req[c1].seq != g_req[c2].seq, "requests did not all go out");
+    uint8_t want[] = {HRTBT, MSTR, 2, 'H', g_req[h].seq, CRY, MSTR, 2, 'C', g_req[c1].seq,
+                      CRY, MSTR, 2, 'C', g_req[c2].seq};
+    CHECK(out_is(want, (int)sizeof(want)), "requests not on the ring as [cmd, seq] (%d bytes)", out_n());
+
+    reply(CRY, 'C', 22, g_req[c2].seq);
+    reply(CRY, 'C', 11, g_req[c1].seq);
+    reply(HRTBT, 'H', 33, g_req[h].seq);
+    settle();
+    int v1 = req_wait(c1), v2 = req_wait(c2), vh = req_wait(h);
+    CHECK(v1 == 11 && v2 == 22 && vh == 33, "got %d %d %d, want 11 22 33", v1, v2, vh);
+}
+
+// a reply that comes in after its request timed out is not the answer to the next one
+static void check_req_late(void)
+{
+    printf("late reply after a timeout\n");
+    int a = req_send(CRY, 'C', TIMEOUT);
+    uint8_t seq = g_req[a].seq;
+    CHECK(req_wait(a) == -1, "an unanswered request did not time out");
+
+    int b = req_send(CRY, 'C', REQ_TEST_MS);
+    reply(CRY, 'C', 44, seq);
+    settle();
+    req_poll();
+    CHECK(req_check(b) == -2, "the late reply was taken for the newer request");
+    reply(CRY, 'C', 55, g_req[b].seq);
+    settle();
+    int v = req_wait(b);
+    CHECK(v == 55, "newer request got %d, want 55", v);
+}
+
+// the sequence number wraps around and skips RX_FILL: no request ends in it
+static void check_req_wrap(void)
+{
+    printf("seq wraps past RX_FILL\n");
+    g_req_seq = RX_FILL - 1;
+    out_clear();
+    int r[3];
+    for (int i = 0; i < 3; i++)
+        r[i] = req_send(CRY, 'C', REQ_TEST_MS);
+    CHECK(g_req[r[0]].seq == RX_FILL - 1 && g_req[r[1]].seq == 0 && g_req[r[2]].seq == 1,
+          "seqs %d %d %d, want %d 0 1", g_req[r[0]].seq, g_req[r[1]].seq, g_req[r[2]].seq, RX_FILL - 1);
+    pthread_mutex_lock(&g_out_lock);
+    int ends_in_fill = 0;
+    for (int i = 4; i < g_out_n; i += 5)
+        ends_in_fill |= (g_out[i] == RX_FILL);
+    pthread_mutex_unlock(&g_out_lock);
+    CHECK(!ends_in_fill, "a request went out ending in RX_FILL");
+
+    for (int i = 2; i >= 0; i--)
+        reply(CRY, 'C', (uint8_t)(60 + i), g_req[r[i]].seq);
+    settle();
+    int ok = 1;
+    for (int i = 0; i < 3; i++)
+        ok &= (req_wait(r[i]) == 60 + i);
+    CHECK(ok, "replies across the wrap not matched to their requests");
+}
+
+// with every slot out, a further request is refused (-1) and only a freed slot takes one again
+static void check_req_full(void)
+{
+    printf("all REQ_SLOTS in use\n");
+    int r[REQ_SLOTS], distinct = 1;
+    for (int i = 0; i < REQ_SLOTS; i++)
+    {
+        r[i] = req_send(CRY, 'C', REQ_TEST_MS);
+        for (int k = 0; k < i; k++)
+            distinct &= (r[i] >= 0 && r[k] != r[i]);
+    }
+    CHECK(r[0] >= 0 && distinct, "REQ_SLOTS requests did not get a slot each");
+    int more = req_send(CRY, 'C', REQ_TEST_MS);
+    CHECK(more == -1, "request %d got slot %d with all taken", REQ_SLOTS + 1, more);
+    CHECK(req_wait(-1) == -1 && req_check(-1) == -1, "a refused request did not read as timed out");
+    CHECK(req_check(r[0]) == -2, "a request still out was not reported as such");
+
+    reply(CRY, 'C', 66, g_req[r[3]].seq);
+    settle();
+    req_poll();
+    CHECK(req_check(r[3]) == 66, "the answered request did not give its value back");
+    int again = req_send(CRY, 'C', REQ_TEST_MS);
+    CHECK(again == r[3], "the freed slot was not taken again (got %d)", again);
+
+    // the rest are never answered
+    int timed_out = 1;
+    for (int i = 0; i < REQ_SLOTS; i++)
+        if (i != 3)
+            timed_out &= (req_wait(r[i]) == -1);
+    timed_out &= (req_wait(again) == -1);
+    CHECK(timed_out, "unanswered requests did not time out");
+}
+
+// FAKE SENSOR NODES
+// For vitals_get, which blocks on its polls: a thread reads the master's requests off the ring and
+// answers 'H' / 'C' with g_sensors.value and 'S' with an ack, counting both per node ([0] HRTBT, [1] CRY).
+static struct
+{
+    pthread_mutex_t lock;
+    int stop;
+    int value[2];
+    int polled[2];
+    int subscribed[2];
+} g_sensors = {PTHREAD_MUTEX_INITIALIZER, 0, {0, 0}, {0, 0}, {0, 0}};
+
+static void *sensor_thread(void *arg)
+{
+    (void)arg;
+    int pos = 0; // next unread byte of g_out
+    while (1)
+    {
+        pthread_mutex_lock(&g_sensors.lock);
+        int stop = g_sensors.stop;
+        pthread_mutex_unlock(&g_sensors.lock);
+        if (stop)
+            return NULL;
+
+        uint8_t f[3 + 255];
+        int got = 0;
+        pthread_mutex_lock(&g_out_lock);
+        if (pos > g_out_n)
+            pos = 0; // out_clear
+        if (pos + 3 <= g_out_n && pos + 3 + g_out[pos + 2] <= g_out_n)
+        {
+            got = 3 + g_out[pos + 2];
+            memcpy(f, g_out + pos, (size_t)got);
+            pos += got;
+        }
+        pthread_mutex_unlock(&g_out_lock);
+        if (!got)
+        {
+            usleep(200);
+            continue;
+        }
+
+        if ((f[0] != HRTBT && f[0] != CRY) || f[1] != MSTR || f[2] < 2)
+            continue;
+        int k = (f[0] == HRTBT) ? 0 : 1;
+        uint8_t cmd = f[3], seq = f[got - 1];
+        pthread_mutex_lock(&g_sensors.lock);
+        if (cmd == (k ? 'C' : 'H'))
+        {
+            g_sensors.polled[k]++;
+            reply(f[0], cmd, (uint8_t)g_sensors.value[k], seq);
+        }
+        else if (cmd == 'S')
+        {
+            g_sensors.subscribed[k]++;
+            uint8_t ack[] = {MSTR, f[0], 2, 'S', seq};
+            feed(ack, (int)sizeof(ack));
+        }
+        pthread_mutex_unlock(&g_sensors.lock);
+    }
+}
+
+static void sensors_set(int bpm, int cry)
+{
+    pthread_mutex_lock(&g_sensors.lock);
+    g_sensors.value[0] = bpm;
+    g_sensors.value[1] = cry;
+    pthread_mutex_unlock(&g_sensors.lock);
+}
+
+// requests answered so far: polls of both nodes, and subscriptions of both
+static void sensors_count(int *polled, int *subscribed)
+{
+    pthread_mutex_lock(&g_sensors.lock);
+    *polled = g_sensors.polled[0] + g_sensors.polled[1];
+    *subscribed = g_sensors.subscribed[0] + g_sensors.subscribed[1];
+    pthread_mutex_unlock(&g_sensors.lock);
+}
+
+// a push ['P', cmd, value] from src
+static void push(uint8_t src, uint8_t cmd, uint8_t value)
+{
+    uint8_t f[] = {MSTR, src, 3, 'P', cmd, value};
+    feed(f, (int)sizeof(f));
+}
+
+// no pushes yet: poll and subscribe. Pushes: used as they are, a push of the other node's reading
+// ignored. Pushes gone for VITALS_STALE_MS: poll again and subscribe again
+static void check_vitals(void)
+{
+    printf("vitals: stale, polled, subscribed again\n");
+    out_clear(); // the earlier requests are not for the sensor nodes to answer
+    pthread_t t;
+    pthread_create(&t, NULL, sensor_thread, NULL);
+    int bpm, cry, polled, subscribed;
+
+    sensors_set(70, 30);
+    vitals_get(&bpm, &cry);
+    sensors_count(&polled, &subscribed);
+    CHECK(bpm == 70 && cry == 30, "no pushes yet: got %d %d, want the polled 70 30", bpm, cry);
+    CHECK(polled == 2 && subscribed == 2, "no pushes yet: %d polls, %d subscriptions, want 2 and 2", polled,
+          subscribed);
+
+    push(HRTBT, 'H', 80);
+    push(CRY, 'C', 40);
+    push(HRTBT, 'C', 99); // not what the heartbeat node was subscribed for
+    push(CRY, 'H', 98);
+    settle();
+    vitals_get(&bpm, &cry);
+    sensors_count(&polled, &subscribed);
+    CHECK(bpm == 80 && cry == 40, "pushed: got %d %d, want 80 40", bpm, cry);
+    CHECK(polled == 2 && subscribed == 2, "polled (%d) or subscribed (%d) again while pushes came in", polled,
+          subscribed);
+
+    sensors_set(75, 35);
+    usleep((VITALS_STALE_MS + 50) * 1000);
+    vitals_get(&bpm, &cry);
+    sensors_count(&polled, &subscribed);
+    CHECK(bpm == 75 && cry == 35, "pushes gone: got %d %d, want the polled 75 35", bpm, cry);
+    CHECK(polled == 4 && subscribed == 4, "pushes gone: %d polls, %d subscriptions, want 4 and 4", polled,
+          subscribed);
+
+    push(HRTBT, 'H', 85);
+    push(CRY, 'C', 45);
+    settle();
+    vitals_get(&bpm, &cry);
+    sensors_count(&polled, &subscribed);
+    CHECK(bpm == 85 && cry == 45 && polled == 4, "pushes back: got %d %d after %d polls, want 85 45 and 4", bpm,
+          cry, polled);
+
+    pthread_mutex_lock(&g_sensors.lock);
+    g_sensors.stop = 1;
+    pthread_mutex_unlock(&g_sensors.lock);
+    pthread_join(t, NULL);
+}
+#endif
+
+int main(void)
+{
+    rx_start();
+    check_split();
+    check_forward();
+    check_full();
+    check_cut_off();
+#ifndef RX_MASTER
+    check_stall();
+#else
+    check_req_order();
+    check_req_late();
+    check_req_wrap();
+    check_req_full();
+    check_vitals();
+#endif
+    printf("%s: %s\n", RX_NODE_NAME, g_failed ? "FAIL" : "PASS");
+    return g_failed ? 1 : 0;
+}
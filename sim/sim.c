@@ -1,82 +1,404 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <time.h>
 #include <math.h>
-#include <windows.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdarg.h>
+
+#include "controller.h" // the production decision logic, shared with ../decision
+#include "plant.h"      // move rules, shared with the controller's MPC rollouts
 
 #define AMP_CH 0
 #define FREQ_CH 1 // example, this is how its probably going to look like in production
 #define HIST_MAX 2048
 #define CONVERGENCE_TIME 4
+#define MAX_CONTROLLER_STEPS 40 // run_controller gives up after this many decisions
+
+// History mode. 0 = dense samples every SAMPLE_DT (interpolated reads).
+// 1 = change points only: S is piecewise constant (it only changes in move_to_cell,
+//     go_panic and converge_now), so we store (t, S) segments and read S(t - tau) exactly.
+//     Memory then scales with the number of moves, not with simulated seconds.
+#ifndef HIST_CHANGE_POINTS
+#define HIST_CHANGE_POINTS 0
+#endif
+
+// Compile-time log level (set with -DSIM_LOG_LEVEL=n, see Makefile).
+// 0 = silent: every SIM_LOG/SIM_WARN compiles to nothing, for throughput benchmarks
+// 1 = warnings, errors and panics only
+// 2 = full trace of every move, sense and decision (default)
+#ifndef SIM_LOG_LEVEL
+#define SIM_LOG_LEVEL 2
+#endif
+
+// PCG32 (O'Neill, pcg-random.org): 16 bytes of state, one multiply per draw.
+// every sim_ctx owns one so a seed replays bit-exactly and threads never share RNG state.
+typedef struct sim_rng
+{
+    uint64_t state;
+    uint64_t inc; // stream selector, must be odd
+} sim_rng;
+
+static inline uint32_t rng_next(sim_rng *r)
+{
+    uint64_t old = r->state;
+    r->state = old * 6364136223846793005ULL + r->inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+}
+
+void rng_seed(sim_rng *r, uint64_t seed, uint64_t stream)
+{
+    r->state = 0u;
+    r->inc = (stream << 1u) | 1u;
+    rng_next(r);
+    r->state += seed;
+    rng_next(r);
+}
+
+// uniform integer in [0, n) without modulo bias
+static inline uint32_t rng_below(sim_rng *r, uint32_t n)
+{
+    uint32_t threshold = (0u - n) % n;
+    for (;;)
+    {
+        uint32_t x = rng_next(r);
+        if (x >= threshold)
+            return x % n;
+    }
+}
+
+// EVENT QUEUE
+// The clock jumps from event to event instead of ticking through every TAU.
+// A motor move lands after motor_latency, the plant converges CONVERGENCE_TIME later,
+// the sensors are read and the controller wakes up TAU after the plant settled (or every wake_period).
+// A strategy with a settle detector is also polled every POLL_SEC in between and may wake early.
+enum
+{
+    EV_MOTOR_MOVE,  // commanded cell reaches the plant (a, f)
+    EV_CONVERGE,    // plant settles on Sopt of the cell it moved to
+    EV_SENSOR_READ, // sample delayed BPM / CRY
+    EV_CTRL_WAKE,   // controller runs one decision on the last read
+    EV_CTRL_POLL    // ask the strategy's settle detector whether to wake now
+};
+
+#define POLL_SEC (TAU_SAMPLE_MS / 1000.0) // the cradle's vitals polling period
+#define WATCH_CHECK_SEC 1.0 // -P: two samples over WATCH_CRY, one more if the first read sits on the jump
+#define RESTART_STEP 6      // -r: the master restarts right before this step
 
-double Sopt[10];
-double BandLow[10];
-double BandHigh[10];
-int K[5][5];     // stress matrix (internal to sim; controller won't read it)
-int curA = 4;    // start at A5 (row index 4)(current a)
-int curF = 4;    // start at F5 (col index 4)(current f)
-int curK = 9;    // start at K9(current K)
-double S = 95.0; // current stress (0..100)
-double heartbeat = 240;
+#define EVQ_MAX 16 // a handful are ever pending at once
 
-// simulation clock & dense history sampling (no real waiting) ====
-// keep my sanity: we move time ourselves so delayed reads have data to interpolate. what is time?
-double sim_t = 0.0;      // simulated seconds since start
-double SAMPLE_DT = 0.05; // record history every 50 ms for nice interpolation
-double TAU = 10.0;       // heartbeat delay seconds (controller’s guess)
+typedef struct sim_event
+{
+    double t;     // when it fires (simulated seconds)
+    unsigned seq; // insertion order, keeps equal timestamps FIFO
+    int type;     // EV_*
+    int a, f;     // target cell for EV_MOTOR_MOVE
+    unsigned gen; // move_gen for EV_CONVERGE, wake_gen for the rest: stale ones are dropped
+} sim_event;
+
+#define STRATEGY_STATE_MAX 2048 // bytes of opaque controller state per baby
+
+// One simulated baby: plant, clock, history and controller state.
+// Everything the sim touches lives in here so many babies can run side by side (one ctx per thread).
+typedef struct sim_ctx
+{
+    // plant (inverse model)
+    double Sopt[10];
+    double BandLow[10];
+    double BandHigh[10];
+    int K[5][5];      // stress matrix (internal to sim; controller won't read it)
+    int curA;         // start at A5 (row index 4)(current a)
+    int curF;         // start at F5 (col index 4)(current f)
+    int curK;         // start at K9(current K)
+    double S;         // current stress (0..100)
+    double heartbeat;
+
+    // simulation clock & dense history sampling (no real waiting) ====
+    // keep my sanity: we move time ourselves so delayed reads have data to interpolate. what is time?
+    double sim_t;     // simulated seconds since start
+    double SAMPLE_DT; // record history every 50 ms for nice interpolation
+    double TAU;       // heartbeat delay seconds (controller’s guess)
+
+    // heartbeat- this is where shit goes crazy
+    // circular history: hist_head is the oldest sample, hist_n how many are valid.
+    // logical sample i (0 = oldest) lives at hist_t[(hist_head + i) % HIST_MAX].
+    double hist_t[HIST_MAX]; // timestamps (seconds since start)
+    double hist_s[HIST_MAX]; // recorded S values
+    int hist_head;           // physical index of the oldest sample
+    int hist_n;              // number of samples stored
+    double hist_last_t;      // change points: when S was last recorded, i.e. the dense ring's newest sample
+
+    // CONTROLLER: one entry of the strategy table (see CONTROLLER STRATEGIES) and its private state.
+    // the sim never looks inside strat, only the strategy's own functions do.
+    int thresholdBPM; // knob handed to the strategy on reset
+    const struct sim_strategy *strategy;
+    const unsigned char *policy; // table strategy: the table under test, NULL = compiled-in policy_table
+    unsigned *policy_visits;     // table strategy: +1 per state looked up, NULL = not counted
+    union
+    {
+        unsigned char bytes[STRATEGY_STATE_MAX];
+        double align_d;
+        void *align_p;
+        long long align_l;
+    } strat;
+
+    // event queue: binary min-heap on (t, seq)
+    sim_event evq[EVQ_MAX];
+    int evq_n;
+    unsigned evq_seq;
+    unsigned move_gen;    // bumped by every move, a pending convergence only counts for the latest one
+    unsigned wake_gen;    // bumped by an early wake, the read / wake lined up before it are dropped
+    double wake_at;       // when the pending EV_CTRL_WAKE fires, polls stop there
+    int plant_busy;       // motor moves / convergences still pending
+    double motor_latency; // seconds between command_motor and the plant seeing the move
+    double wake_period;   // 0 = wake TAU after the plant settled (original timing), > 0 = fixed period
+    double S_tau_meas;    // last EV_SENSOR_READ
+    int bpm_meas;
+    int cry_meas;
+
+    // bookkeeping for batch runs
+    int verbose;     // 0 = no printing (batch workers), 1 = full trace
+    int steps;       // controller steps taken by run_controller
+    int panic_count; // go_panic calls
+    int calm;        // 1 once A1 F1 / K1 was reached
+    int hit_limit;   // 1 if run_controller ran out of MAX_CONTROLLER_STEPS
+    unsigned seed;   // seed for generate_matrix
+    sim_rng rng;     // private generator, reseeded from seed by generate_matrix
+    int path;        // K9 -> K1 path shape as a move mask (see PATH SHAPES)
+
+    // -P watchdog check: the first LEFT probe made in the crying range panics the plant, the next
+    // command has to take the cradle back to where the probe came from within WATCH_CHECK_SEC, and
+    // the step after that has to wait until the plant has converged there
+    int force_panic;      // 1 = armed, 2 = panicked, waiting for that command, 3 = backed out, waiting
+                          // for the next step, 0 = off or done
+    int probe_a, probe_f; // where the probe came from
+    double forced_at;     // when the plant panicked
+    int backed_out;       // 1 = backed out in time, -1 = not, 0 = no such probe
+    int settled_step;     // 1 = the step after the back-out read the converged cell, -1 = not, 0 = no such step
+
+    // -r restart check: the master restarts once mid-run and has to pick its snapshot back up
+    int restart;   // 1 = armed, 0 = off or done
+    int restarted; // 1 = restarted and restored the snapshot, -1 = restarted, snapshot refused, 0 = not restarted
+} sim_ctx;
+
+// printf that stays quiet for batch workers (c->verbose) and vanishes below its log level.
+// the silent variants still "use" c so nothing turns into an unused-variable warning.
+#if SIM_LOG_LEVEL >= 2
+#define SIM_LOG(c, ...)           \
+    do                            \
+    {                             \
+        if ((c)->verbose)         \
+            printf(__VA_ARGS__);  \
+    } while (0)
+#else
+#define SIM_LOG(c, ...) ((void)(c))
+#endif
+
+#if SIM_LOG_LEVEL >= 1
+#define SIM_WARN(c, ...)          \
+    do                            \
+    {                             \
+        if ((c)->verbose)         \
+            printf(__VA_ARGS__);  \
+    } while (0)
+#else
+#define SIM_WARN(c, ...) ((void)(c))
+#endif
+
+// reset a context to the power-on state (A5 F5, K9, empty history, default tuning)
+void sim_init(sim_ctx *c)
+{
+    for (int k = 0; k < 10; k++)
+    {
+        c->Sopt[k] = 0.0;
+        c->BandLow[k] = 0.0;
+        c->BandHigh[k] = 0.0;
+    }
+    for (int a = 0; a < 5; a++)
+        for (int f = 0; f < 5; f++)
+            c->K[a][f] = 0;
+    c->curA = 4;
+    c->curF = 4;
+    c->curK = 9;
+    c->S = 95.0;
+    c->heartbeat = 240;
+
+    c->sim_t = 0.0;
+    c->SAMPLE_DT = 0.05;
+    c->TAU = 10.0;
+    c->hist_head = 0;
+    c->hist_n = 0;
+    c->hist_last_t = 0.0;
+
+    c->thresholdBPM = 10;
+    c->strategy = NULL;
+    c->policy = NULL;
+    c->policy_visits = NULL;
+    memset(&c->strat, 0, sizeof(c->strat));
+
+    c->evq_n = 0;
+    c->evq_seq = 0;
+    c->move_gen = 0;
+    c->wake_gen = 0;
+    c->wake_at = 0.0;
+    c->plant_busy = 0;
+    c->motor_latency = 0.0;
+    c->wake_period = 0.0;
+    c->S_tau_meas = 0.0;
+    c->bpm_meas = 0;
+    c->cry_meas = 0;
+
+    c->verbose = 1;
+    c->steps = 0;
+    c->panic_count = 0;
+    c->calm = 0;
+    c->hit_limit = 0;
+    c->seed = 0;
+    rng_seed(&c->rng, 0, 0);
+    c->path = -1;
+    c->force_panic = 0;
+    c->probe_a = c->probe_f = -1;
+    c->forced_at = 0.0;
+    c->backed_out = 0;
+    c->settled_step = 0;
+    c->restart = 0;
+    c->restarted = 0;
+}
 
-// heartbeat- this is where shit goes crazy
-double hist_t[HIST_MAX]; // timestamps (seconds since start)
-double hist_s[HIST_MAX]; // recorded S values
-int hist_n = 0;          // number of samples stored
+// physical slot of logical sample i
+static inline int hist_idx(const sim_ctx *c, int i)
+{
+    int p = c->hist_head + i;
+    return (p >= HIST_MAX) ? p - HIST_MAX : p;
+}
 
-// Append a (time, S) sample
-void record_stress_sample(double t_sec, double S_val)
+// Append a (time, S) sample. O(1): once full, overwrite the oldest slot.
+void record_stress_sample(sim_ctx *c, double t_sec, double S_val)
 {
-    if (hist_n < HIST_MAX)
+#if HIST_CHANGE_POINTS
+    // only a change of S opens a new segment. Several at one instant each get theirs: the first
+    // segment has to keep the value S started with, stress_delayed reads it like the dense ring does
+    c->hist_last_t = t_sec;
+    if (c->hist_n > 0 && c->hist_s[hist_idx(c, c->hist_n - 1)] == S_val)
+        return;
+#endif
+    if (c->hist_n < HIST_MAX)
     {
-        hist_t[hist_n] = t_sec;
-        hist_s[hist_n] = S_val;
-        hist_n++;
+        int p = hist_idx(c, c->hist_n);
+        c->hist_t[p] = t_sec;
+        c->hist_s[p] = S_val;
+        c->hist_n++;
     }
     else
     {
-        // simplest overwrite behavior: shift left (slow but easy)
-        for (int i = 1; i < HIST_MAX; i++)
-        {
-            hist_t[i - 1] = hist_t[i];
-            hist_s[i - 1] = hist_s[i];
-        }
-        hist_t[HIST_MAX - 1] = t_sec;
-        hist_s[HIST_MAX - 1] = S_val;
+        c->hist_t[c->hist_head] = t_sec;
+        c->hist_s[c->hist_head] = S_val;
+        c->hist_head = (c->hist_head + 1 == HIST_MAX) ? 0 : c->hist_head + 1;
     }
 }
 
 // drive the simulation time forward by dt and keep recording S while time passes
-void advance_time(double dt)
+void advance_time(sim_ctx *c, double dt)
 {
     if (dt <= 0)
         return;
+    // S is constant while time passes. The change-point build records nothing, but steps the clock in
+    // the same SAMPLE_DT pieces: the rounding of the sum decides which events land on one instant
     double remain = dt;
     while (remain > 1e-9)
     {
-        double step = (remain > SAMPLE_DT) ? SAMPLE_DT : remain;
-        sim_t += step;
-        record_stress_sample(sim_t, S);
+        double step = (remain > c->SAMPLE_DT) ? c->SAMPLE_DT : remain;
+        c->sim_t += step;
+#if !HIST_CHANGE_POINTS
+        record_stress_sample(c, c->sim_t, c->S);
+#endif
         remain -= step;
     }
+#if HIST_CHANGE_POINTS
+    c->hist_last_t = c->sim_t;
+#endif
 }
 
 // tiny nudge to separate equal timestamps in logs when we instant-set S
-void advance_epsilon(void)
+void advance_epsilon(sim_ctx *c)
 {
-    sim_t += 0.01; // 10 ms nudge
-    record_stress_sample(sim_t, S);
+    c->sim_t += 0.01; // 10 ms nudge
+#if HIST_CHANGE_POINTS
+    c->hist_last_t = c->sim_t;
+#else
+    record_stress_sample(c, c->sim_t, c->S);
+#endif
 }
 
 // get "now"
-double now_sec(void) { return sim_t; }
+double now_sec(const sim_ctx *c) { return c->sim_t; }
+
+// at the same instant the plant moves and converges first: a read or wake then sees the new level,
+// as a read at the convergence instant does on the cradle
+static inline int ev_before(const sim_event *x, const sim_event *y)
+{
+    int px = x->type <= EV_CONVERGE, py = y->type <= EV_CONVERGE;
+    return x->t < y->t || (x->t == y->t && (px > py || (px == py && x->seq < y->seq)));
+}
+
+// schedule an event dt seconds from now
+void evq_push(sim_ctx *c, double dt, int type, int a, int f)
+{
+    if (c->evq_n >= EVQ_MAX)
+    {
+        SIM_WARN(c, "[SYSTEM][ERROR] event queue full, event %d dropped\n", type);
+        return;
+    }
+    sim_event ev = {now_sec(c) + dt, c->evq_seq++, type, a, f, (type == EV_CONVERGE) ? c->move_gen : c->wake_gen};
+
+    // sift up
+    int i = c->evq_n++;
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+        if (!ev_before(&ev, &c->evq[parent]))
+            break;
+        c->evq[i] = c->evq[parent];
+        i = parent;
+    }
+    c->evq[i] = ev;
+}
+
+// take the earliest event, returns 0 when the queue is empty
+int evq_pop(sim_ctx *c, sim_event *out)
+{
+    if (c->evq_n == 0)
+        return 0;
+    *out = c->evq[0];
+
+    // sift the last one down from the root
+    sim_event last = c->evq[--c->evq_n];
+    int i = 0;
+    for (;;)
+    {
+        int child = 2 * i + 1;
+        if (child >= c->evq_n)
+            break;
+        if (child + 1 < c->evq_n && ev_before(&c->evq[child + 1], &c->evq[child]))
+            child++;
+        if (!ev_before(&c->evq[child], &last))
+            break;
+        c->evq[i] = c->evq[child];
+        i = child;
+    }
+    c->evq[i] = last;
+    return 1;
+}
+
+void evq_clear(sim_ctx *c)
+{
+    c->evq_n = 0;
+    c->plant_busy = 0;
+}
 
 // Linear interpolation helper. This is the same as Linear approximation. Turns out that is actually really usefull irl.
 double lerp(double x0, double y0, double x1, double y1, double x)
@@ -88,45 +410,73 @@ double lerp(double x0, double y0, double x1, double y1, double x)
 }
 
 // Return S(t - tau). If not enough history, fall back sensibly.
-double stress_delayed(double now_sec_val, double tau_sec)
+// The search runs over logical indices so the wrap point of the ring is invisible here.
+double stress_delayed(const sim_ctx *c, double now_sec_val, double tau_sec)
 {
-    if (hist_n == 0)
-        return S;
+    if (c->hist_n == 0)
+        return c->S;
 
     const double EPS = 1e-6;
     double target = now_sec_val - tau_sec;
 
+#if HIST_CHANGE_POINTS
+    // The same S the dense ring below reads: S after every change at or before target, so a read
+    // that lands on a change instant sees the new S. Its clamps too: at or before the first sample,
+    // S as it started; within EPS of the newest sample, S now. (The dense ring forgets samples
+    // older than HIST_MAX * SAMPLE_DT, about 100 s, and then reads differently for a TAU that long.)
+    if (target <= c->hist_t[hist_idx(c, 0)] + EPS)
+        return c->hist_s[hist_idx(c, 0)];
+    if (target >= c->hist_last_t - EPS)
+        return c->hist_s[hist_idx(c, c->hist_n - 1)];
+
+    int lo = 0, hi = c->hist_n; // first logical index with t > target
+    while (lo < hi)
+    {
+        int mid = (lo + hi) >> 1;
+        if (c->hist_t[hist_idx(c, mid)] <= target + EPS)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return c->hist_s[hist_idx(c, lo - 1)];
+#else
+    int first = hist_idx(c, 0);
+    int last = hist_idx(c, c->hist_n - 1);
+
     // clamp to history bounds
-    if (target <= hist_t[0] + EPS)
-        return hist_s[0];
-    if (target >= hist_t[hist_n - 1] - EPS)
-        return hist_s[hist_n - 1];
+    if (target <= c->hist_t[first] + EPS)
+        return c->hist_s[first];
+    if (target >= c->hist_t[last] - EPS)
+        return c->hist_s[last];
 
-    // binary search for the first index with time >= target
-    int lo = 0, hi = hist_n - 1;
+    // binary search for the first logical index with time >= target
+    int lo = 0, hi = c->hist_n - 1;
     while (lo < hi)
     {
         int mid = (lo + hi) >> 1;
-        if (hist_t[mid] < target)
+        if (c->hist_t[hist_idx(c, mid)] < target)
             lo = mid + 1;
         else
             hi = mid;
     }
     // lo is the first index with t >= target
-    int i1 = lo;     // t[i1] >= target
-    int i0 = i1 - 1; // t[i0] <  target
+    int i1 = hist_idx(c, lo);     // t[i1] >= target
+    int i0 = hist_idx(c, lo - 1); // t[i0] <  target
 
-    // if we basically hit an exact timestamp, return it
-    if (fabs(hist_t[i1] - target) <= EPS)
-        return hist_s[i1];
-    if (fabs(hist_t[i0] - target) <= EPS)
-        return hist_s[i0];
+    // if we basically hit an exact timestamp, return it. A change instant holds two samples, the old S
+    // (advance_time got there) and the new one: the plant has moved by then, so read the newest
+    if (fabs(c->hist_t[i1] - target) <= EPS)
+    {
+        while (lo + 1 < c->hist_n && fabs(c->hist_t[hist_idx(c, lo + 1)] - target) <= EPS)
+            i1 = hist_idx(c, ++lo);
+        return c->hist_s[i1];
+    }
+    if (fabs(c->hist_t[i0] - target) <= EPS)
+        return c->hist_s[i0];
 
     // linear interpolate between the bracketing samples
-    double x0 = hist_t[i0], y0 = hist_s[i0];
-    double x1 = hist_t[i1], y1 = hist_s[i1];
-    double u = (target - x0) / (x1 - x0);
-    return y0 + u * (y1 - y0);
+    return lerp(c->hist_t[i0], c->hist_s[i0], c->hist_t[i1], c->hist_s[i1], target);
+#endif
 }
 
 // MOTOR
@@ -177,18 +527,18 @@ void set_pwm_percent(int channel, int percent)
 }
 
 // forward decl (sim engine)
-void move_to_cell(int newA, int newF);
+void move_to_cell(sim_ctx *c, int newA, int newF);
 
 // amp, freq are percentages (0-100).
 // Any value inside an interval maps to that (A,F) cell.
 // We "command" the cradle logically via move_to_cell(A-1, F-1).
 // aIndex, fIndex are 0-4 (matrix indices)
-void command_motor(int aIndex, int fIndex)
+void command_motor(sim_ctx *c, int aIndex, int fIndex)
 {
     // safety
     if (aIndex < 0 || aIndex > 4 || fIndex < 0 || fIndex > 4)
     {
-        printf("[SYSTEM][ERROR] command_motor out-of-bounds A%d F%d\n",
+        SIM_WARN(c, "[SYSTEM][ERROR] command_motor out-of-bounds A%d F%d\n",
                aIndex + 1, fIndex + 1);
         return;
     }
@@ -200,11 +550,22 @@ void command_motor(int aIndex, int fIndex)
     set_pwm_percent(AMP_CH, dutyA);
     set_pwm_percent(FREQ_CH, dutyF);
 
-    move_to_cell(aIndex, fIndex);
+    if (c->force_panic == 2)
+    {
+        c->force_panic = 3;
+        c->backed_out = (aIndex == c->probe_a && fIndex == c->probe_f &&
+                         now_sec(c) - c->forced_at <= WATCH_CHECK_SEC) ? 1 : -1;
+        SIM_WARN(c, "[CHECK] first command after the forced panic: A%d F%d %.2f s later, %s\n", aIndex + 1,
+                 fIndex + 1, now_sec(c) - c->forced_at, (c->backed_out > 0) ? "backed out" : "NOT backed out");
+    }
+
+    // the cradle gets there motor_latency later (EV_MOTOR_MOVE -> move_to_cell)
+    evq_push(c, c->motor_latency, EV_MOTOR_MOVE, aIndex, fIndex);
+    c->plant_busy++;
 }
 
 // simulated crying based on current stress level
-double get_crying()
+static double crying_of(double S)
 {
     if (S <= 100 && S >= 50)
         return 100.0;
@@ -214,124 +575,170 @@ double get_crying()
         return 0;
 }
 
-double get_heartbeat(double stress_delayed_val)
+static double heartbeat_of(double S)
+{
+    return 60.0 + 1.8 * S;
+}
+
+double get_crying(const sim_ctx *c)
+{
+    return crying_of(c->S);
+}
+
+double get_heartbeat(sim_ctx *c, double stress_delayed_val)
 {
-    heartbeat = 60.0 + 1.8 * stress_delayed_val;
-    return heartbeat;
+    c->heartbeat = heartbeat_of(stress_delayed_val);
+    return c->heartbeat;
 }
 
 // Force system into K9 panic and make outputs match Sopt[9]
-void go_panic(const char *tag)
+void go_panic(sim_ctx *c, const char *tag)
 {
     // 1) set stress to K9's Sopt and record immediately
-    S = Sopt[9];
-    record_stress_sample(now_sec(), S);
+    c->S = c->Sopt[9];
+    c->panic_count++;
+    record_stress_sample(c, now_sec(c), c->S);
 
     // 3) recompute outputs coherently
 
-    heartbeat = get_heartbeat(S);
-
-    int cry_now = (int)round(get_crying());
+    get_heartbeat(c, c->S);
 
     // 4) log + tiny nudge to separate timestamps
-    printf("[%s] PANIC -> S=%.1f, HB=%.0f, CRY=%d @t=%.2f\n",
-           tag, S, heartbeat, cry_now, now_sec());
+    SIM_WARN(c, "[%s] PANIC -> S=%.1f, HB=%.0f, CRY=%d @t=%.2f\n",
+           tag, c->S, c->heartbeat, (int)round(get_crying(c)), now_sec(c));
+    (void)tag; // only used by the log line
 
-    advance_epsilon();
+    advance_epsilon(c);
 }
 
-void generate_matrix()
+// Sopt per K level and the band around it, drawn from the baby's rng
+void generate_bands(sim_ctx *c)
 {
-    int a, f;
-
-    srand(time(0)); // intialize the random seed
-
     // determine the first sopt for level K1 (idk if the sopt for k1 is always zero but well see)
-    Sopt[1] = 10.0 + (rand() % 6); // 5 + a random value between 0-5
+    c->Sopt[1] = 10.0 + rng_below(&c->rng, 6); // 5 + a random value between 0-5
 
     // each next Sopt is increased by a small random step of  (7-14), capped at 98
     for (int k = 2; k <= 9; k++)
     {
-        int step = 7.0 + (rand() % 5); // 7 + a random value between 0-5
-        int next = (int)(Sopt[k - 1] + step);
+        int step = 7.0 + rng_below(&c->rng, 5); // 7 + a random value between 0-5
+        int next = (int)(c->Sopt[k - 1] + step);
         if (next > 98.0)
             next = 98.0;
-        if (next <= Sopt[k - 1])
-            next = (int)(Sopt[k - 1] + 1.0); // strictly increasing
-        Sopt[k] = next;
+        if (next <= c->Sopt[k - 1])
+            next = (int)(c->Sopt[k - 1] + 1.0); // strictly increasing
+        c->Sopt[k] = next;
     }
     // Sopt for K9 is Spanic (i think)
 
     // ideally every step has a range of 11ish. we are going to move based on that. This is just an assumption
     for (int k = 1; k <= 9; k++)
     {
-        double half = 6.0 + (rand() % 7); // random value between 6-12
-        BandLow[k] = Sopt[k] - half;
-        BandHigh[k] = Sopt[k] + half;
-        if (BandLow[k] < 0.0)
-            BandLow[k] = 0.0;
-        if (BandHigh[k] > 100.0)
-            BandHigh[k] = 100.0;
+        double half = 6.0 + rng_below(&c->rng, 7); // random value between 6-12
+        c->BandLow[k] = c->Sopt[k] - half;
+        c->BandHigh[k] = c->Sopt[k] + half;
+        if (c->BandLow[k] < 0.0)
+            c->BandLow[k] = 0.0;
+        if (c->BandHigh[k] > 100.0)
+            c->BandHigh[k] = 100.0;
     }
 
     // Guarantee: previous K's upper bound contains latter K's Sopt ---
     for (int k = 2; k <= 9; k++)
     {
-        if (BandHigh[k - 1] < Sopt[k])
+        if (c->BandHigh[k - 1] < c->Sopt[k])
         {
-            BandHigh[k - 1] = Sopt[k];
-            if (BandHigh[k - 1] > 100.0)
-                BandHigh[k - 1] = 100.0;
-            if (BandLow[k - 1] > BandHigh[k - 1])
-                BandLow[k - 1] = BandHigh[k - 1];
+            c->BandHigh[k - 1] = c->Sopt[k];
+            if (c->BandHigh[k - 1] > 100.0)
+                c->BandHigh[k - 1] = 100.0;
+            if (c->BandLow[k - 1] > c->BandHigh[k - 1])
+                c->BandLow[k - 1] = c->BandHigh[k - 1];
         }
     }
+}
+
+// PATH SHAPES
+// The K9 -> K1 path is a monotone lattice path: 8 moves, exactly 4 LEFT and 4 UP.
+// We encode it as an 8 bit mask, bit i = move i counted from A5 F5 (0 = LEFT, 1 = UP).
+// That gives C(8,4) = 70 possible shapes.
+#define PATH_MOVES 8
+#define PATH_SHAPES 70
+
+static int popcount8(int m)
+{
+    int n = 0;
+    for (; m; m &= m - 1)
+        n++;
+    return n;
+}
+
+// the i-th valid path mask in increasing order (0 <= i < PATH_SHAPES), -1 if out of range
+int path_shape(int i)
+{
+    for (int m = 0; m < (1 << PATH_MOVES); m++)
+    {
+        if (popcount8(m) == PATH_MOVES / 2 && i-- == 0)
+            return m;
+    }
+    return -1;
+}
+
+// "LLUULUUL" style text for a path mask, out needs PATH_MOVES + 1 chars
+void path_to_str(int mask, char *out)
+{
+    for (int i = 0; i < PATH_MOVES; i++)
+        out[i] = ((mask >> i) & 1) ? 'U' : 'L';
+    out[PATH_MOVES] = '\0';
+}
+
+// parse "LLUULUUL" back into a mask, -1 if it is not a valid path
+int path_from_str(const char *s)
+{
+    int mask = 0;
+    for (int i = 0; i < PATH_MOVES; i++)
+    {
+        if (s[i] == 'U' || s[i] == 'u')
+            mask |= 1 << i;
+        else if (s[i] != 'L' && s[i] != 'l')
+            return -1;
+    }
+    if (s[PATH_MOVES] != '\0' || popcount8(mask) != PATH_MOVES / 2)
+        return -1;
+    return mask;
+}
+
+// lay the path into K and fill the rest of the matrix from it
+void build_matrix_from_path(sim_ctx *c, int mask)
+{
+    int a, f;
+
+    c->path = mask;
 
     // build the stress matrix(empty now)
     for (a = 0; a < 5; a++)
     {
         for (f = 0; f < 5; f++)
         {
-            K[a][f] = 0;
+            c->K[a][f] = 0;
         }
     }
 
     // endpoints
-    K[0][0] = 1; // A1 F1
-    K[4][4] = 9; // A5 F5
+    c->K[0][0] = 1; // A1 F1
+    c->K[4][4] = 9; // A5 F5
 
-    /* RANDOM path from K9 K1 (LEFT/UP moves) */
     int adx = 4;  // start at A5 (row 4)
     int fdx = 4;  // start at F5 (col 4)
     int kcur = 9; // current K label at start
 
-    int leftMoves = 4;
-    int upMoves = 4;
-
-    while (kcur > 1)
+    for (int i = 0; i < PATH_MOVES; i++)
     {
-        int dir; // 0 = LEFT, 1 = UP
-
-        if (leftMoves == 0)
-            dir = 1; // must go UP
-        else if (upMoves == 0)
-            dir = 0; // must go LEFT
+        if ((mask >> i) & 1)
+            adx = adx - 1; // UP
         else
-            dir = rand() % 2;
-
-        if (dir == 0 && leftMoves > 0 && (fdx - 1) >= 0)
-        {
-            fdx = fdx - 1;
-            leftMoves--;
-        }
-        else if (dir == 1 && upMoves > 0 && (adx - 1) >= 0)
-        {
-            adx = adx - 1;
-            upMoves--;
-        }
+            fdx = fdx - 1; // LEFT
 
-        kcur = kcur - 1;    // lower the k
-        K[adx][fdx] = kcur; // place K on the path
+        kcur = kcur - 1;       // lower the k
+        c->K[adx][fdx] = kcur; // place K on the path
     }
 
     /*
@@ -341,14 +748,14 @@ void generate_matrix()
     {
         for (f = 4; f >= 0; f--)
         {
-            if (K[a][f] == 0)
+            if (c->K[a][f] == 0)
             {
 
                 int m = 1;
-                if (f + 1 < 5 && K[a][f + 1] > m)
+                if (f + 1 < 5 && c->K[a][f + 1] > m)
                 {
-                    m = K[a][f + 1];
-                    K[a][f] = m;
+                    m = c->K[a][f + 1];
+                    c->K[a][f] = m;
                 }
             }
         }
@@ -358,180 +765,220 @@ void generate_matrix()
     {
         for (f = 4; f >= 0; f--)
         {
-            if (K[a][f] == 0) // row-column
+            if (c->K[a][f] == 0) // row-column
             {
 
                 int m = 1;
-                if (a + 1 < 5 && K[a + 1][f] > m)
+                if (a + 1 < 5 && c->K[a + 1][f] > m)
                 {
-                    m = K[a + 1][f];
-                    K[a][f] = m;
+                    m = c->K[a + 1][f];
+                    c->K[a][f] = m;
                 }
             }
         }
     }
 
     // keep my sanity
-    K[0][0] = 1;
-    K[4][4] = 9;
+    c->K[0][0] = 1;
+    c->K[4][4] = 9;
+}
 
+void print_matrix(const sim_ctx *c)
+{
     for (int k = 1; k <= 9; k++)
     {
-        printf("K%d: Sopt=%5.1f  range=[%5.1f, %5.1f]\n",
-               k, Sopt[k], BandLow[k], BandHigh[k]);
+        SIM_LOG(c, "K%d: Sopt=%5.1f  range=[%5.1f, %5.1f]\n",
+                k, c->Sopt[k], c->BandLow[k], c->BandHigh[k]);
     }
 
-    printf("\n");
+    SIM_LOG(c, "\n");
 
-    for (a = 0; a < 5; a++)
+    for (int a = 0; a < 5; a++)
     {
-        for (f = 0; f < 5; f++)
+        for (int f = 0; f < 5; f++)
         {
-            printf("K%d", K[a][f]);
+            SIM_LOG(c, "K%d", c->K[a][f]);
             if (f < 4)
-                printf(" ");
+                SIM_LOG(c, " ");
+        }
+        SIM_LOG(c, "\n");
+    }
+}
+
+// bands from the seed, then either a RANDOM path from K9 K1 (LEFT/UP moves) or the fixed shape in path_mask
+void generate_matrix(sim_ctx *c, int path_mask)
+{
+    rng_seed(&c->rng, c->seed, 0); // intialize the random seed (per baby, same seed -> same matrix)
+
+    generate_bands(c);
+
+    if (path_mask < 0)
+    {
+        int leftMoves = 4;
+        int upMoves = 4;
+
+        path_mask = 0;
+        for (int i = 0; i < PATH_MOVES; i++)
+        {
+            int dir; // 0 = LEFT, 1 = UP
+
+            if (leftMoves == 0)
+                dir = 1; // must go UP
+            else if (upMoves == 0)
+                dir = 0; // must go LEFT
+            else
+                dir = (int)rng_below(&c->rng, 2);
+
+            if (dir)
+                upMoves--;
+            else
+                leftMoves--;
+            path_mask |= dir << i;
         }
-        printf("\n");
     }
+
+    build_matrix_from_path(c, path_mask);
+    print_matrix(c);
 }
 
-int in_range(int k, double v)
+int in_range(const sim_ctx *c, int k, double v)
 {
     if (k < 1 || k > 9)
         return 0;
-    return (v >= BandLow[k] && v <= BandHigh[k]);
+    return (v >= c->BandLow[k] && v <= c->BandHigh[k]);
 }
 
-void print_status(const char *tag)
+void print_status(const sim_ctx *c, const char *tag)
 {
-    printf("[%s] pos=A%d F%d  K%d  S=%.1f  (band %.1f-%.1f  Sopt=%.1f) @t=%.2f\n",
-           tag, curA + 1, curF + 1, curK, S, BandLow[curK], BandHigh[curK], Sopt[curK], now_sec());
+    (void)tag; // whole function compiles away below SIM_LOG_LEVEL 2
+    SIM_LOG(c, "[%s] pos=A%d F%d  K%d  S=%.1f  (band %.1f-%.1f  Sopt=%.1f) @t=%.2f\n",
+           tag, c->curA + 1, c->curF + 1, c->curK, c->S,
+           c->BandLow[c->curK], c->BandHigh[c->curK], c->Sopt[c->curK], now_sec(c));
 }
 
-// Converge to Sopt of current K after ~2 seconds IF inside range
+// Converge to Sopt of current K CONVERGENCE_TIME after the move IF inside range
 // we need to wait for convergence to sopt because we know sopt is guarenteed to be in the lower Ks range. or else we would cause a stress jump
-void converge_now()
+void schedule_converge(sim_ctx *c)
+{
+    evq_push(c, CONVERGENCE_TIME, EV_CONVERGE, 0, 0);
+    c->plant_busy++;
+}
+
+// EV_CONVERGE handler
+void converge_now(sim_ctx *c)
+{
+    c->S = c->Sopt[c->curK];
+    record_stress_sample(c, now_sec(c), c->S);
+    print_status(c, "[SYSTEM]converged");
+}
+
+// what the plant does when the cradle goes from (oldA, oldF) / oldK at stress S to (newA, newF).
+// the rule itself is plant_classify (../decision/plant.h), shared with the controller's MPC rollouts
+int classify_move(const sim_ctx *c, int oldA, int oldF, int oldK, double S, int newA, int newF)
 {
-    advance_time(CONVERGENCE_TIME);
-    S = Sopt[curK];
-    record_stress_sample(now_sec(), S);
-    print_status("[SYSTEM]converged");
+    int targetK = c->K[newA][newF];
+    return plant_classify(oldA, oldF, c->BandLow[oldK], c->BandHigh[oldK], S,
+                          newA, newF, c->BandLow[targetK], c->BandHigh[targetK]);
 }
 
 /* called when you change cell. You MUST pass the K-label for that cell.
    newA/newF are 0..4 indexes (A1-A5 -> 0-4, F1-F5 -> 0-4). newK is 1-9.
 */
-void move_to_cell(int newA, int newF)
+void move_to_cell(sim_ctx *c, int newA, int newF)
 {
     if (newA < 0 || newA > 4 || newF < 0 || newF > 4)
     {
-        printf("[SYSTEM][ERROR] out-of-bounds move A%d F%d ignored.\n", newA + 1, newF + 1);
+        SIM_WARN(c, "[SYSTEM][ERROR] out-of-bounds move A%d F%d ignored.\n", newA + 1, newF + 1);
         return;
     }
 
-    int oldA = curA;
-    int oldF = curF;
-    int oldK = curK;
+    int oldA = c->curA;
+    int oldF = c->curF;
+    int oldK = c->curK;
 
-    int targetK = K[newA][newF];
+    int targetK = c->K[newA][newF];
+    c->move_gen++; // any convergence still pending belongs to the old cell
 
-    printf("\n[SYSTEM] MOVE request: A%d F%d  K%d ---> A%d F%d  K%d \n",
+    SIM_LOG(c, "\n[SYSTEM] MOVE request: A%d F%d  K%d ---> A%d F%d  K%d \n",
            oldA + 1, oldF + 1, oldK, newA + 1, newF + 1, targetK);
 
-    int softerA = (newA < oldA);
-    int softerF = (newF < oldF);
-    int harderA = (newA > oldA);
-    int harderF = (newF > oldF);
+    int kind = classify_move(c, oldA, oldF, oldK, c->S, newA, newF);
 
-    int is_soft = ((softerA || softerF) && !(harderA || harderF));
-    int is_hard = ((harderA || harderF) && !(softerA || softerF));
-
-    int overlap = 1;
-    if (BandHigh[oldK] < BandLow[targetK] || BandLow[oldK] > BandHigh[targetK])
-        overlap = 0;
+    // -P: a LEFT probe while crying is in the range the anchor search reads it in panics, whatever the matrix
+    // says. Not the last move into A1 F1: the run ends there, with nothing left to back out of
+    double cry = crying_of(c->S);
+    int forced = (c->force_panic == 1 && newA == oldA && newF == oldF - 1 && (newA || newF) && cry > 15 && cry < 52);
+    if (forced)
+    {
+        kind = MOVE_PANIC_JUMP;
+        c->force_panic = 2;
+        c->probe_a = oldA;
+        c->probe_f = oldF;
+        c->forced_at = now_sec(c);
+    }
 
-    curA = newA;
-    curF = newF;
-    curK = targetK;
+    c->curA = newA;
+    c->curF = newF;
+    c->curK = targetK;
 
-    if (in_range(curK, S))
+    switch (kind)
     {
-        printf("[SYSTEM] inside-band");
-        converge_now();
-
+    case MOVE_INSIDE:
+        SIM_LOG(c, "[SYSTEM] inside-band");
+        schedule_converge(c);
         return;
-    }
 
-    if (!overlap)
-    {
-        if (is_soft)
-        {
-            go_panic("PANIC JUMP");
-            return;
-        }
-        else if (is_hard)
-        {
-            go_panic("PANIC BLOCK");
-            return;
-        }
-        else
-        {
-            if (S < BandLow[curK])
-                S = BandLow[curK];
-            if (S > BandHigh[curK])
-                S = BandHigh[curK];
-            record_stress_sample(now_sec(), S);
-            print_status("[SYSTEM] mixed-move-converge");
-            converge_now();
+    case MOVE_PANIC_JUMP:
+        go_panic(c, forced ? "FORCED PANIC" : "PANIC JUMP");
+        return;
 
-            return;
-        }
+    case MOVE_PANIC_BLOCK:
+        go_panic(c, "PANIC BLOCK");
+        return;
     }
 
-    if (S < BandLow[curK])
-        S = BandLow[curK];
-    if (S > BandHigh[curK])
-        S = BandHigh[curK];
-    record_stress_sample(now_sec(), S);
-    printf("[SYSTEM][WARNING] overlap-converge. This is an unwanted message");
-    converge_now();
+    if (c->S < c->BandLow[c->curK])
+        c->S = c->BandLow[c->curK];
+    if (c->S > c->BandHigh[c->curK])
+        c->S = c->BandHigh[c->curK];
+    record_stress_sample(c, now_sec(c), c->S);
+    if (kind == MOVE_MIXED)
+        print_status(c, "[SYSTEM] mixed-move-converge");
+    else
+        SIM_WARN(c, "[SYSTEM][WARNING] overlap-converge. This is an unwanted message");
+    schedule_converge(c);
 }
 
 // CONTROLLR LOGIC
 // recuresive???
+// the sim's own controller, kept as the baseline strategy ("legacy"). its state is a legacy_state.
+typedef struct legacy_state
+{
+    int lastBPM;
+    int thresholdBPM;
+    int crying_started; // keep for future, unused in simple rule
 
-// evaluate heartbeat improvement thresholds
-// controller state
-// CONTROLLER STATE
-int lastBPM = 0;
-int thresholdBPM = 10;
-int crying_started = 0; // keep for future, unused in simple rule
-
-// remember where we came from (anchor cell)
-int prevA = -1;
-int prevF = -1;
+    // remember where we came from (anchor cell)
+    int prevA;
+    int prevF;
 
-// add at top-level
-int anchorA_mem = -1, anchorF_mem = -1;
-int triedLeftFromAnchor = 0;
+    int anchorA_mem, anchorF_mem;
+    int triedLeftFromAnchor;
 
-// how we moved last step from (prevA,prevF) to current
-// 0 = none/initial, 1 = left (F-1), 2 = up (A-1)
-int lastMoveDir = 0;
+    // how we moved last step from (prevA,prevF) to current
+    // 0 = none/initial, 1 = left (F-1), 2 = up (A-1)
+    int lastMoveDir;
+} legacy_state;
 
 // set starting state once, after you call generate_matrix(). keep my sanity.
-void set_initial_state(int aIndex, int fIndex, int kLabel, double Sstart)
+void set_initial_state(sim_ctx *c, int aIndex, int fIndex, int kLabel, double Sstart)
 {
-    curA = aIndex;
-    curF = fIndex;
-    curK = kLabel;
-    S = Sstart;
-    record_stress_sample(now_sec(), S);
-    print_status("init");
-
-    prevA = curA;
-    prevF = curF;
-    lastMoveDir = 0;
+    c->curA = aIndex;
+    c->curF = fIndex;
+    c->curK = kLabel;
+    c->S = Sstart;
+    record_stress_sample(c, now_sec(c), c->S);
+    print_status(c, "init");
 }
 
 // Return 1 if BPM looks better than before, 0 otherwise.
@@ -539,75 +986,70 @@ void set_initial_state(int aIndex, int fIndex, int kLabel, double Sstart)
 // "Improved" = closer to calm:
 // - either near rest (<= 60 + thresholdBPM)
 // - or dropped by at least thresholdBPM vs lastBPM
-// replace your signature or keep it the same and read globals
-int heartbeat_improved(int bpm_now)
+int heartbeat_improved(const sim_ctx *c, const legacy_state *st, int bpm_now)
 {
     // immediate improvement: lower K than where we came from
-    if (curK < K[prevA][prevF])
+    if (c->curK < c->K[st->prevA][st->prevF])
         return 1;
 
-    if (bpm_now <= 60 + thresholdBPM)
+    if (bpm_now <= 60 + st->thresholdBPM)
         return 1;
-    if (lastBPM > 0 && bpm_now <= lastBPM - thresholdBPM)
+    if (st->lastBPM > 0 && bpm_now <= st->lastBPM - st->thresholdBPM)
         return 1;
     return 0;
 }
 
-void run_decision_once(void)
+void run_decision_once(sim_ctx *c, legacy_state *st)
 {
-    // 1) Catch up to the LAST move.
-    advance_time(TAU);
+    // 1) + 2) the scheduler already waited for the last move and read the sensors (EV_SENSOR_READ)
+    int bpm_now = c->bpm_meas;
 
-    // 2) Sense delayed stress -> BPM/CRY
-    double S_tau = stress_delayed(now_sec(), TAU);
-    int bpm_now = (int)round(get_heartbeat(S_tau));
-    int cry_now = (int)round(get_crying());
-
-    printf("[SENSE] S_tau=%.1f  BPM=%d  CRY=%d  pos=A%d F%d K%d @t=%.2f\n",
-           S_tau, bpm_now, cry_now, curA + 1, curF + 1, curK, now_sec());
+    // crying is only logged, this controller decides on BPM alone
+    SIM_LOG(c, "[SENSE] S_tau=%.1f  BPM=%d  CRY=%d  pos=A%d F%d K%d @t=%.2f\n",
+           c->S_tau_meas, bpm_now, c->cry_meas, c->curA + 1, c->curF + 1, c->curK, now_sec(c));
 
     // 3) Evaluate last move
-    int improved = heartbeat_improved(bpm_now);
+    int improved = heartbeat_improved(c, st, bpm_now);
 
     // Ensure anchor memory is aligned with our current "home" cell when idle
-    if (lastMoveDir == 0)
+    if (st->lastMoveDir == 0)
     {
-        if (anchorA_mem != curA || anchorF_mem != curF)
+        if (st->anchorA_mem != c->curA || st->anchorF_mem != c->curF)
         {
-            anchorA_mem = curA;
-            anchorF_mem = curF;
-            triedLeftFromAnchor = 0; // new anchor => haven't tried LEFT here
+            st->anchorA_mem = c->curA;
+            st->anchorF_mem = c->curF;
+            st->triedLeftFromAnchor = 0; // new anchor => haven't tried LEFT here
         }
     }
 
     // 4) choose first trial from this anchor
-    if (lastMoveDir == 0)
+    if (st->lastMoveDir == 0)
     {
-        prevA = curA;
-        prevF = curF;
+        st->prevA = c->curA;
+        st->prevF = c->curF;
 
-        if (!triedLeftFromAnchor && curF > 0)
+        if (!st->triedLeftFromAnchor && c->curF > 0)
         {
-            lastMoveDir = 1;         // LEFT
-            triedLeftFromAnchor = 1; // remember we tried LEFT at this anchor
-            printf("[ALGORITHM] initial/pick -> try LEFT from A%d F%d\n", curA + 1, curF + 1);
-            command_motor(curA, curF - 1);
-            lastBPM = bpm_now;
+            st->lastMoveDir = 1;         // LEFT
+            st->triedLeftFromAnchor = 1; // remember we tried LEFT at this anchor
+            SIM_LOG(c, "[ALGORITHM] initial/pick -> try LEFT from A%d F%d\n", c->curA + 1, c->curF + 1);
+            command_motor(c, c->curA, c->curF - 1);
+            st->lastBPM = bpm_now;
             return;
         }
-        else if (curA > 0)
+        else if (c->curA > 0)
         {
-            lastMoveDir = 2; // UP
-            printf("[ALGORITHM] initial/pick -> try UP from A%d F%d (LEFT tried/blocked)\n", curA + 1, curF + 1);
-            command_motor(curA - 1, curF);
-            lastBPM = bpm_now;
+            st->lastMoveDir = 2; // UP
+            SIM_LOG(c, "[ALGORITHM] initial/pick -> try UP from A%d F%d (LEFT tried/blocked)\n", c->curA + 1, c->curF + 1);
+            command_motor(c, c->curA - 1, c->curF);
+            st->lastBPM = bpm_now;
             return;
         }
         else
         {
             // Nowhere softer to go
-            printf("[ALGORITHM] at softest corner; waiting");
-            lastBPM = bpm_now;
+            SIM_LOG(c, "[ALGORITHM] at softest corner; waiting");
+            st->lastBPM = bpm_now;
             return;
         }
     }
@@ -617,116 +1059,1752 @@ void run_decision_once(void)
     //    - if not     -> backtrack to previous (prevA, prevF) and keep LEFT-tried flag
     if (improved)
     {
-        int anchorA = curA;
-        int anchorF = curF;
-        printf("[ALGORITHM] last move (dir=%d) IMPROVED -> new anchor at A%d F%d\n",
-               lastMoveDir, anchorA + 1, anchorF + 1);
+        int anchorA = c->curA;
+        int anchorF = c->curF;
+        SIM_LOG(c, "[ALGORITHM] last move (dir=%d) IMPROVED -> new anchor at A%d F%d\n",
+               st->lastMoveDir, anchorA + 1, anchorF + 1);
 
         // Refresh anchor memory and reset LEFT attempt flag
-        if (anchorA_mem != anchorA || anchorF_mem != anchorF)
+        if (st->anchorA_mem != anchorA || st->anchorF_mem != anchorF)
         {
-            anchorA_mem = anchorA;
-            anchorF_mem = anchorF;
-            triedLeftFromAnchor = 0;
+            st->anchorA_mem = anchorA;
+            st->anchorF_mem = anchorF;
+            st->triedLeftFromAnchor = 0;
         }
 
         // From the new anchor, prefer LEFT; else UP
-        prevA = anchorA;
-        prevF = anchorF;
+        st->prevA = anchorA;
+        st->prevF = anchorF;
 
         if (anchorF > 0)
         {
-            lastMoveDir = 1;         // LEFT
-            triedLeftFromAnchor = 1; // about to try LEFT here
-            printf("[ALGORITHM] improved -> next try LEFT from A%d F%d\n", anchorA + 1, anchorF + 1);
-            command_motor(anchorA, anchorF - 1);
+            st->lastMoveDir = 1;         // LEFT
+            st->triedLeftFromAnchor = 1; // about to try LEFT here
+            SIM_LOG(c, "[ALGORITHM] improved -> next try LEFT from A%d F%d\n", anchorA + 1, anchorF + 1);
+            command_motor(c, anchorA, anchorF - 1);
         }
         else if (anchorA > 0)
         {
-            lastMoveDir = 2; // UP
-            printf("[ALGORITHM] improved -> next try UP from A%d F%d\n", anchorA + 1, anchorF + 1);
-            command_motor(anchorA - 1, anchorF);
+            st->lastMoveDir = 2; // UP
+            SIM_LOG(c, "[ALGORITHM] improved -> next try UP from A%d F%d\n", anchorA + 1, anchorF + 1);
+            command_motor(c, anchorA - 1, anchorF);
         }
-        
 
-        lastBPM = bpm_now;
+
+        st->lastBPM = bpm_now;
         return;
     }
     else
     {
         // No improvement.
         // If we just moved LEFT but K didn't change, switch direction to UP immediately.
-        if (lastMoveDir == 1 && K[curA][curF] == K[prevA][prevF])
+        if (st->lastMoveDir == 1 && c->K[c->curA][c->curF] == c->K[st->prevA][st->prevF])
         {
-            int anchorA = prevA;
-            int anchorF = prevF;
+            int anchorA = st->prevA;
+            int anchorF = st->prevF;
 
             if (anchorA > 0)
             {
                 // Try UP from the anchor without an extra backtrack cycle.
-                printf("[ALGORITHM] left kept same K -> try UP from A%dF%d\n",
+                SIM_LOG(c, "[ALGORITHM] left kept same K -> try UP from A%dF%d\n",
                        anchorA + 1, anchorF + 1);
 
                 // Re-align to anchor logically
-                curA = anchorA;
-                curF = anchorF;
+                c->curA = anchorA;
+                c->curF = anchorF;
 
-                lastMoveDir = 2; // UP
-                command_motor(anchorA - 1, anchorF);
-                lastBPM = bpm_now;
+                st->lastMoveDir = 2; // UP
+                command_motor(c, anchorA - 1, anchorF);
+                st->lastBPM = bpm_now;
                 return;
             }
             // If can't go UP, fall through to standard backtrack.
         }
 
         // Standard backtrack path (unchanged)
-        int anchorA = prevA, anchorF = prevF;
-        if (anchorA != curA || anchorF != curF)
+        int anchorA = st->prevA, anchorF = st->prevF;
+        if (anchorA != c->curA || anchorF != c->curF)
         {
-            printf("[ALGORITHM] last move (dir=%d) NO IMPROVEMENT -> backtrack to A%dF%d\n",
-                   lastMoveDir, anchorA + 1, anchorF + 1);
-            command_motor(anchorA, anchorF);
+            SIM_LOG(c, "[ALGORITHM] last move (dir=%d) NO IMPROVEMENT -> backtrack to A%dF%d\n",
+                   st->lastMoveDir, anchorA + 1, anchorF + 1);
+            command_motor(c, anchorA, anchorF);
         }
-        curA = anchorA;
-        curF = anchorF;
-        lastMoveDir = 0; // re-bootstrap next cycle
-        lastBPM = bpm_now;
+        st->lastMoveDir = 0; // re-bootstrap next cycle
+        st->lastBPM = bpm_now;
+        return;
+    }
+}
+
+// CONTROLLER STRATEGIES
+// A strategy is one controller the sim can drive: a vtable over its own opaque state in c->strat.
+// The batch runs every selected strategy on the same seeds (-c), so adding one to sim_strategies[]
+// is all it takes to benchmark it against the others.
+typedef struct sim_strategy
+{
+    const char *name;
+    const char *desc;
+    size_t state_size; // must fit STRATEGY_STATE_MAX
+
+    // fresh state for a new baby; the matrix is generated and the plant is at its start cell
+    void (*init)(sim_ctx *c, void *st);
+    // one decision on c->bpm_meas / c->cry_meas, moves go through command_motor
+    void (*step)(sim_ctx *c, void *st);
+    // seconds until the next step; NULL = TAU after the plant settled (original timing)
+    double (*period)(const sim_ctx *c, const void *st);
+    // 1 if a run that reached A1 F1 / K1 this way does not count as calm; NULL = never
+    int (*panicked)(const void *st);
+    // polled every POLL_SEC between steps, 1 = the plant has settled, step now; NULL = wait the period
+    int (*settled)(sim_ctx *c, void *st);
+    // -r: restart the controller as a fresh boot would, from what it saved before; 0 = it took the
+    // snapshot back. NULL = keeps nothing across a restart
+    int (*restart)(sim_ctx *c, void *st);
+    int boot_step; // 1 = first step right at t = 0, otherwise TAU (or one -W period) in
+} sim_strategy;
+
+static void *strategy_state(sim_ctx *c)
+{
+    return c->strat.bytes;
+}
+
+// legacy: the sim's own LEFT-then-UP anchor search
+static void legacy_init(sim_ctx *c, void *st)
+{
+    legacy_state *l = st;
+    memset(l, 0, sizeof(*l));
+    l->lastBPM = (int)c->heartbeat; // BPM at the start state
+    l->thresholdBPM = c->thresholdBPM;
+    l->prevA = c->curA;
+    l->prevF = c->curF;
+    l->anchorA_mem = -1;
+    l->anchorF_mem = -1;
+}
+
+static void legacy_step(sim_ctx *c, void *st)
+{
+    run_decision_once(c, st);
+}
+
+#if SIM_LOG_LEVEL >= 2
+// controller_state.log sink for traced runs
+static void ctl_log(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+}
+#endif
+
+// cradle: ../decision/controller.c, exactly what the PYNQ master runs
+static void cradle_init(sim_ctx *c, void *st)
+{
+    controller_state *s = st;
+    controller_init(s);
+    s->thresholdBPM = c->thresholdBPM;
+#if SIM_LOG_LEVEL >= 2
+    if (c->verbose)
+        s->log = ctl_log;
+#endif
+}
+
+// what the cradle's main loop sampled since it last looked, for the TAU estimate and the settle detector
+static void cradle_feed(sim_ctx *c, controller_state *s)
+{
+    unsigned now_ms = (unsigned)llround(now_sec(c) * 1000.0);
+    for (unsigned t = s->tauN ? s->tauLastMs + TAU_SAMPLE_MS : now_ms; t <= now_ms; t += TAU_SAMPLE_MS)
+        controller_sample(s, t, (int)round(heartbeat_of(stress_delayed(c, t / 1000.0, c->TAU))),
+                          (int)round(crying_of(stress_delayed(c, t / 1000.0, 0.0))));
+}
+
+static void cradle_step(sim_ctx *c, void *st)
+{
+    cradle_feed(c, st);
+    SIM_LOG(c, "[SENSE] S_tau=%.1f  BPM=%d  CRY=%d  pos=A%d F%d K%d @t=%.2f\n",
+           c->S_tau_meas, c->bpm_meas, c->cry_meas, c->curA + 1, c->curF + 1, c->curK, now_sec(c));
+
+    controller_input in = {c->bpm_meas, c->cry_meas};
+    controller_output out;
+    controller_step(st, &in, &out);
+    if (out.move && (out.a != c->curA || out.f != c->curF))
+        command_motor(c, out.a, out.f);
+}
+
+// the cradle sleeps controller_period_ms after every step
+static double cradle_period(const sim_ctx *c, const void *st)
+{
+    (void)c;
+    return controller_period_ms(st) / 1000.0;
+}
+
+static void schedule_wake(sim_ctx *c);
+
+// between steps the master runs the watchdog on every sample, then steps early once the move has shown
+static int cradle_settled(sim_ctx *c, void *st)
+{
+    cradle_feed(c, st);
+    controller_output out;
+    if (controller_watchdog(st, &out))
+        return 1;
+    if (out.move && (out.a != c->curA || out.f != c->curF))
+    {
+        // a back-out restarts the wait like a step's move, as the master restarts last_step_ms
+        command_motor(c, out.a, out.f);
+        c->wake_gen++;
+        schedule_wake(c);
+        return 0;
+    }
+    return controller_settled(st);
+}
+
+// the master's boot: controller_init, then snapshot_load. The cradle comes back up at the
+// controller's start cell, wherever the motor was
+static int cradle_restart(sim_ctx *c, void *st)
+{
+    controller_snapshot snap;
+    controller_save(st, &snap);
+    c->strategy->init(c, st);
+    int rc = controller_restore(st, &snap);
+    const controller_state *s = st;
+    if (s->curA != c->curA || s->curF != c->curF)
+        command_motor(c, s->curA, s->curF);
+    return rc;
+}
+
+// like the cradle's HUD, a controller that only got to A1 F1 through panic_mode is not calm
+static int cradle_panicked(const void *st)
+{
+    return ((const controller_state *)st)->panic_mode;
+}
+
+// belief: the same controller in CTRL_MODE_BELIEF (Bayesian search over the 70 K paths)
+static void belief_init(sim_ctx *c, void *st)
+{
+    cradle_init(c, st);
+    ((controller_state *)st)->mode = CTRL_MODE_BELIEF;
+}
+
+// mpc: the same controller in CTRL_MODE_MPC (belief + rollouts on sampled plant_snapshots)
+static void mpc_init(sim_ctx *c, void *st)
+{
+    cradle_init(c, st);
+    ((controller_state *)st)->mode = CTRL_MODE_MPC;
+}
+
+// table: the same controller in CTRL_MODE_TABLE, on the table -G is trying out (or policy_table.h)
+static void table_init(sim_ctx *c, void *st)
+{
+    cradle_init(c, st);
+    ((controller_state *)st)->mode = CTRL_MODE_TABLE;
+    ((controller_state *)st)->policy = c->policy;
+}
+
+static void table_step(sim_ctx *c, void *st)
+{
+    cradle_step(c, st);
+    int i = ((const controller_state *)st)->policyState;
+    if (c->policy_visits && i >= 0)
+        c->policy_visits[i]++;
+}
+
+// the first entry is the baseline the others are compared against
+static const sim_strategy sim_strategies[] = {
+    {"legacy", "sim's run_decision_once, LEFT-then-UP anchor search",
+     sizeof(legacy_state), legacy_init, legacy_step, NULL, NULL, NULL, NULL, 0},
+    {"cradle", "../decision controller_step, as on the PYNQ master",
+     sizeof(controller_state), cradle_init, cradle_step, cradle_period, cradle_panicked, cradle_settled,
+     cradle_restart, 1},
+    {"belief", "../decision controller_step in CTRL_MODE_BELIEF, path belief + lookahead",
+     sizeof(controller_state), belief_init, cradle_step, cradle_period, cradle_panicked, cradle_settled,
+     cradle_restart, 1},
+    {"mpc", "../decision controller_step in CTRL_MODE_MPC, rollouts of each move on sampled plants",
+     sizeof(controller_state), mpc_init, cradle_step, cradle_period, cradle_panicked, cradle_settled,
+     cradle_restart, 1},
+    {"table", "../decision controller_step in CTRL_MODE_TABLE, one lookup in policy_table.h",
+     sizeof(controller_state), table_init, table_step, cradle_period, cradle_panicked, cradle_settled,
+     cradle_restart, 1},
+};
+#define SIM_STRATEGIES ((int)(sizeof(sim_strategies) / sizeof(sim_strategies[0])))
+
+// every state_size has to fit the opaque slot in sim_ctx
+typedef char strategy_state_fits[(sizeof(legacy_state) <= STRATEGY_STATE_MAX &&
+                                  sizeof(controller_state) <= STRATEGY_STATE_MAX) ? 1 : -1];
+#define DEFAULT_STRATEGY "cradle"
+
+static const sim_strategy *strategy_find(const char *name)
+{
+    for (int i = 0; i < SIM_STRATEGIES; i++)
+        if (!strcmp(sim_strategies[i].name, name))
+            return &sim_strategies[i];
+    return NULL;
+}
+
+// the plant has nothing pending: stop at rest, otherwise line up the next read + decision
+void plant_settled(sim_ctx *c)
+{
+    // stop if we’ve reached A1F1 and converged near K1 (and the strategy is not panicking)
+    const sim_strategy *s = c->strategy;
+    if (c->curA == 0 && c->curF == 0 && c->curK == 1 && !(s->panicked && s->panicked(strategy_state(c))))
+    {
+        SIM_LOG(c, "[ALGORITHM] rest reached");
+        c->calm = 1;
+        evq_clear(c);
         return;
     }
+
+    // original timing: catch up TAU after the LAST move so the delayed reading reflects it
+    if (!s->period && c->wake_period <= 0 && c->steps < MAX_CONTROLLER_STEPS)
+    {
+        evq_push(c, c->TAU, EV_SENSOR_READ, 0, 0);
+        evq_push(c, c->TAU, EV_CTRL_WAKE, 0, 0);
+    }
+}
+
+// Sense delayed stress -> BPM/CRY
+static void sensor_read(sim_ctx *c)
+{
+    c->S_tau_meas = stress_delayed(c, now_sec(c), c->TAU);
+    c->bpm_meas = (int)round(get_heartbeat(c, c->S_tau_meas));
+    c->cry_meas = (int)round(get_crying(c));
+}
+
+// line up the next read + decision the strategy's period from now (or every -W), with polls in between
+static void schedule_wake(sim_ctx *c)
+{
+    // -W forces a fixed period on any strategy, otherwise it picks its own (or waits for the plant)
+    double period = c->wake_period;
+    if (period <= 0 && c->strategy->period)
+        period = c->strategy->period(c, strategy_state(c));
+    if (period > 0 && c->steps < MAX_CONTROLLER_STEPS)
+    {
+        evq_push(c, period, EV_SENSOR_READ, 0, 0);
+        evq_push(c, period, EV_CTRL_WAKE, 0, 0);
+        c->wake_at = now_sec(c) + period;
+        if (c->strategy->settled && c->wake_period <= 0 && POLL_SEC < period)
+            evq_push(c, POLL_SEC, EV_CTRL_POLL, 0, 0);
+    }
 }
 
-void run_controller()
+static void controller_wake(sim_ctx *c)
 {
-    // Drive the controller for some steps
+    if (c->force_panic == 3)
+    {
+        c->force_panic = 0;
+        c->settled_step = (c->plant_busy == 0 && c->curA == c->probe_a && c->curF == c->probe_f) ? 1 : -1;
+        SIM_WARN(c, "[CHECK] step after the back-out %.2f s after the panic: %s\n", now_sec(c) - c->forced_at,
+                 (c->settled_step > 0) ? "plant converged" : "plant NOT converged");
+    }
+    if (c->restart && c->steps + 1 == RESTART_STEP)
+    {
+        c->restart = 0;
+        c->restarted = c->strategy->restart(c, strategy_state(c)) == 0 ? 1 : -1;
+        SIM_WARN(c, "[CHECK] master restarted before step %d, snapshot %s\n", RESTART_STEP,
+                 (c->restarted > 0) ? "restored" : "NOT restored");
+    }
+    c->steps++;
+    SIM_LOG(c, "\n[ALGORITHM] Controller Step %d \n", c->steps);
+    c->strategy->step(c, strategy_state(c));
+    schedule_wake(c);
+}
 
-    for (int step = 0; step < 40; ++step)
+void handle_event(sim_ctx *c, const sim_event *ev)
+{
+    switch (ev->type)
     {
-        printf("\n[ALGORITHM] Controller Step %d \n", step + 1);
-        run_decision_once();
+    case EV_MOTOR_MOVE:
+        c->plant_busy--;
+        move_to_cell(c, ev->a, ev->f);
+        break;
+
+    case EV_CONVERGE:
+        c->plant_busy--;
+        if (ev->gen == c->move_gen) // a newer move already took the plant elsewhere
+            converge_now(c);
+        break;
+
+    case EV_SENSOR_READ:
+        if (ev->gen == c->wake_gen)
+            sensor_read(c);
+        return;
 
-        // stop if we’ve reached A1F1 and converged near K1
-        if (curA == 0 && curF == 0 && curK == 1){
-            printf("[ALGORITHM] rest reached");
+    case EV_CTRL_WAKE:
+        if (ev->gen == c->wake_gen)
+            controller_wake(c);
+        break;
+
+    case EV_CTRL_POLL:
+        if (ev->gen != c->wake_gen)
             break;
+        if (c->strategy->settled(c, strategy_state(c)))
+        {
+            c->wake_gen++; // the read + wake at the upper bound are not needed any more
+            sensor_read(c);
+            controller_wake(c);
         }
+        else if (ev->gen == c->wake_gen && now_sec(c) + POLL_SEC < c->wake_at - 1e-9) // not rescheduled
+            evq_push(c, POLL_SEC, EV_CTRL_POLL, 0, 0);
+        break;
+    }
+
+    if (c->plant_busy == 0)
+        plant_settled(c);
+}
 
-            
+void run_controller(sim_ctx *c)
+{
+    // Drive the controller for some steps, then jump event to event.
+    // the cradle steps as soon as it boots, the legacy controller waits TAU (or one period) first
+    evq_clear(c);
+    double first = c->strategy->boot_step ? 0.0 : (c->wake_period > 0) ? c->wake_period : c->TAU;
+    evq_push(c, first, EV_SENSOR_READ, 0, 0);
+    evq_push(c, first, EV_CTRL_WAKE, 0, 0);
+
+    sim_event ev;
+    while (!c->calm && evq_pop(c, &ev))
+    {
+        advance_time(c, ev.t - now_sec(c));
+        handle_event(c, &ev);
     }
+
+    if (!c->calm)
+        c->hit_limit = 1;
 }
 
-int main(void)
+// ORACLE
+// The sim knows K, so the fastest possible run to A1 F1 / K1 is a shortest path. Between moves the
+// plant is always settled at S = Sopt[k]: converged on the cell's K, or Sopt[9] after a panic. So a
+// state is (cell, k of S), 25 x 9 of them, and classify_move gives the same outcome move_to_cell would.
+// Each move is charged like the controller's loop: settle (CONVERGENCE_TIME or the panic nudge) and
+// TAU until the next wake. The first wake is TAU after start and the last settle ends the run, so
+// a run of n moves takes sum(settle + TAU), no matter how the controller decides.
+#define ORACLE_NODES (25 * 10) // (a * 5 + f) * 10 + k, k = 1..9
+
+typedef struct oracle_plan
 {
-    generate_matrix();
-    heartbeat = get_heartbeat(Sopt[9]); // much needed on init. also reminds me
-    lastBPM = heartbeat;
-    // that we should wait for tau seconds at the start because if its a delayed value its not going to read anything
-    // until tau seconds are actually passed
+    int n;                       // moves
+    int cell[ORACLE_NODES];      // a * 5 + f after each move
+    int panic[ORACLE_NODES];     // 1 if that move panics
+} oracle_plan;
+
+// minimum time-to-calm for c's matrix from A5 F5 at Sopt[9], -1 if A1 F1 at Sopt[1] is unreachable.
+// allow_panic = 0 drops panicking moves: the plant lets a panic be "cleared" by one overlapping move
+// (the overlap test looks at the cell's band, not at S), which no cradle should do to a baby on purpose.
+// plan (optional) gets the moves of one optimal run.
+double oracle_time_to_calm(const sim_ctx *c, int allow_panic, oracle_plan *plan)
+{
+    double dist[ORACLE_NODES];
+    int prev[ORACLE_NODES];
+    char done[ORACLE_NODES];
+    char via_panic[ORACLE_NODES]; // the best move into v panics
+    for (int v = 0; v < ORACLE_NODES; v++)
+    {
+        dist[v] = INFINITY;
+        prev[v] = -1;
+        done[v] = 0;
+        via_panic[v] = 0;
+    }
 
-    // Start + record first sample (internal sim state)
-    set_initial_state(4, 4, 9, Sopt[9]);
+    int start = (4 * 5 + 4) * 10 + 9;
+    dist[start] = 0.0;
+    int goal = -1;
 
-    run_controller();
+    // Dijkstra, plain array scan: 225 live nodes
+    for (;;)
+    {
+        int u = -1;
+        for (int v = 0; v < ORACLE_NODES; v++)
+            if (!done[v] && dist[v] < INFINITY && (u < 0 || dist[v] < dist[u]))
+                u = v;
+        if (u < 0)
+            break;
+        done[u] = 1;
 
-    printf("\nfinished at t = %.3f s.\n", now_sec());
-    return 0;
+        int cell = u / 10, k = u % 10;
+        int a = cell / 5, f = cell % 5;
+        if (a == 0 && f == 0 && k == 1) // settled at rest; panicking into A1 F1 is not calm
+        {
+            goal = u;
+            break;
+        }
+
+        for (int to = 0; to < 25; to++)
+        {
+            if (to == cell)
+                continue;
+            int na = to / 5, nf = to % 5;
+            int kind = classify_move(c, a, f, c->K[a][f], c->Sopt[k], na, nf);
+            int panic = (kind == MOVE_PANIC_JUMP || kind == MOVE_PANIC_BLOCK);
+            if (panic && !allow_panic)
+                continue;
+            int nk = panic ? 9 : c->K[na][nf];
+            double w = c->motor_latency + (panic ? 0.01 : CONVERGENCE_TIME) + c->TAU;
+
+            int v = to * 10 + nk;
+            if (!done[v] && dist[u] + w < dist[v])
+            {
+                dist[v] = dist[u] + w;
+                prev[v] = u;
+                via_panic[v] = (char)panic;
+            }
+        }
+    }
+
+    if (goal < 0)
+        return -1.0;
+
+    if (plan)
+    {
+        int n = 0;
+        for (int v = goal; v != start; v = prev[v])
+            n++;
+        plan->n = n;
+        for (int v = goal; v != start; v = prev[v])
+        {
+            n--;
+            plan->cell[n] = v / 10;
+            plan->panic[n] = via_panic[v];
+        }
+    }
+    return dist[goal];
+}
+
+// BATCH MODE
+// Monte Carlo over seeded scenarios: every run gets its own K matrix and its own sim_ctx.
+
+// outcome of one scenario
+typedef struct sim_result
+{
+    unsigned seed;
+    int path;      // path shape the matrix was built from
+    int calm;      // reached A1 F1 / K1
+    int steps;     // controller steps used
+    int panics;    // go_panic count
+    int hit_limit; // ran out of MAX_CONTROLLER_STEPS
+    double t_calm; // simulated seconds at the end of the run (time-to-calm when calm)
+    double t_opt;  // oracle time-to-calm for the same matrix, < 0 when not computed
+    int backed_out; // -P: 1 = the forced panic was backed out in time, -1 = not, 0 = never forced
+    int settled_step; // -P: 1 = the step after the back-out read the converged cell, -1 = not, 0 = never forced
+    int restarted;  // -r: 1 = restarted and restored, -1 = snapshot refused, 0 = never restarted
+} sim_result;
+
+typedef struct batch_cfg
+{
+    int runs;
+    int threads;
+    unsigned seed0; // run i uses seed0 + i
+    double tau;
+    int thresholdBPM;
+    int path;  // fixed path shape for every run, -1 = random per seed
+    int draws; // > 0: enumerate all PATH_SHAPES x draws Sopt/band seeds instead
+    double wake_period;   // controller period, 0 = TAU after the plant settled
+    double motor_latency; // command -> plant delay
+    int lockstep;         // 1: SoA plant, SIM_LANES babies per worker in lockstep (see LOCKSTEP)
+    int regret;           // 1: run the ORACLE on every matrix and report actual - optimal
+    const sim_strategy *strategy; // controller driven by this batch
+    const unsigned char *policy;  // table strategy: table to run, NULL = policy_table.h
+    unsigned *policy_visits;      // table strategy: per-state lookup counts, single thread only
+    int force_panic;              // -P: watchdog check, see sim_ctx.force_panic
+    int restart;                  // -r: restart check, see sim_ctx.restart
+} batch_cfg;
+
+// fresh ctx, seeded matrix, start at A5 F5 K9, ready for the controller
+// path_mask < 0 draws a random path from the seed, otherwise that shape is used
+void sim_setup_scenario(sim_ctx *c, unsigned seed, int path_mask, const batch_cfg *cfg, int verbose)
+{
+    sim_init(c);
+    c->verbose = verbose;
+    c->seed = seed;
+    c->TAU = cfg->tau;
+    c->thresholdBPM = cfg->thresholdBPM;
+    c->wake_period = cfg->wake_period;
+    c->motor_latency = cfg->motor_latency;
+    c->strategy = cfg->strategy;
+    c->policy = cfg->policy;
+    c->policy_visits = cfg->policy_visits;
+    c->force_panic = cfg->force_panic;
+    c->restart = cfg->restart;
+
+    generate_matrix(c, path_mask);
+
+    get_heartbeat(c, c->Sopt[9]); // much needed on init. also reminds me
+    // that we should wait for tau seconds at the start because if its a delayed value its not going to read anything
+    // until tau seconds are actually passed
+
+    // Start + record first sample (internal sim state)
+    set_initial_state(c, 4, 4, 9, c->Sopt[9]);
+    c->strategy->init(c, strategy_state(c));
+}
+
+void sim_collect_result(const sim_ctx *c, unsigned seed, const batch_cfg *cfg, sim_result *out)
+{
+    out->seed = seed;
+    out->path = c->path;
+    out->calm = c->calm;
+    out->steps = c->steps;
+    out->panics = c->panic_count;
+    out->hit_limit = c->hit_limit;
+    out->t_calm = now_sec(c);
+    out->t_opt = cfg->regret ? oracle_time_to_calm(c, 0, NULL) : -1.0;
+    out->backed_out = (c->force_panic == 2) ? -1 : c->backed_out; // forced, and never commanded anything after
+    out->settled_step = (c->force_panic >= 2) ? -1 : c->settled_step; // or never stepped again
+    out->restarted = c->restarted;
+}
+
+// full scenario: setup, run the controller, collect
+void sim_run_scenario(sim_ctx *c, unsigned seed, int path_mask, const batch_cfg *cfg, int verbose, sim_result *out)
+{
+    sim_setup_scenario(c, seed, path_mask, cfg, verbose);
+    run_controller(c);
+    sim_collect_result(c, seed, cfg, out);
+}
+
+// which scenario run i of the batch is
+static void batch_scenario(const batch_cfg *cfg, int i, unsigned *seed, int *path)
+{
+    if (cfg->draws > 0)
+    {
+        *path = path_shape(i / cfg->draws);
+        *seed = cfg->seed0 + (unsigned)(i % cfg->draws);
+    }
+    else
+    {
+        *path = cfg->path;
+        *seed = cfg->seed0 + (unsigned)i;
+    }
+}
+
+// one work-stealing deque per worker: a contiguous range [next, end) of run indices.
+// the owner takes from the front, thieves split off the back half.
+typedef struct batch_queue
+{
+    pthread_mutex_t lock;
+    int next;
+    int end;
+} batch_queue;
+
+typedef struct batch_pool
+{
+    const batch_cfg *cfg;
+    batch_queue *q;
+    sim_result *res;
+} batch_pool;
+
+typedef struct batch_worker
+{
+    batch_pool *pool;
+    int id;
+} batch_worker;
+
+// take the next run from our own queue, -1 if empty
+static int queue_pop(batch_queue *q)
+{
+    int i = -1;
+    pthread_mutex_lock(&q->lock);
+    if (q->next < q->end)
+        i = q->next++;
+    pthread_mutex_unlock(&q->lock);
+    return i;
+}
+
+// steal the back half of some other worker's range into our (empty) queue.
+// returns the first stolen run index, -1 when every queue is empty.
+static int queue_steal(batch_pool *p, int self)
+{
+    int n = p->cfg->threads;
+    for (int k = 1; k < n; k++)
+    {
+        batch_queue *v = &p->q[(self + k) % n];
+        int lo = 0, hi = 0;
+
+        pthread_mutex_lock(&v->lock);
+        int remain = v->end - v->next;
+        if (remain > 0)
+        {
+            lo = v->next + remain / 2; // remain == 1 -> take the last one
+            hi = v->end;
+            v->end = lo;
+        }
+        pthread_mutex_unlock(&v->lock);
+
+        if (hi > lo)
+        {
+            batch_queue *mine = &p->q[self];
+            pthread_mutex_lock(&mine->lock);
+            mine->next = lo + 1;
+            mine->end = hi;
+            pthread_mutex_unlock(&mine->lock);
+            return lo;
+        }
+    }
+    return -1;
+}
+
+// next run for this worker: own queue first, then steal. -1 when the batch is done
+static int next_run(batch_pool *p, int self)
+{
+    int i = queue_pop(&p->q[self]);
+    if (i < 0)
+        i = queue_steal(p, self);
+    return i;
+}
+
+static void *lockstep_worker_main(batch_worker *w);
+
+static void *batch_worker_main(void *arg)
+{
+    batch_worker *w = (batch_worker *)arg;
+    batch_pool *p = w->pool;
+    const batch_cfg *cfg = p->cfg;
+
+    if (cfg->lockstep)
+        return lockstep_worker_main(w);
+
+    sim_ctx *c = malloc(sizeof(*c)); // ~33 KB, too big for a thread stack
+    if (!c)
+        return NULL;
+
+    for (;;)
+    {
+        int i = next_run(p, w->id);
+        if (i < 0)
+            break;
+        unsigned seed;
+        int path;
+        batch_scenario(cfg, i, &seed, &path);
+        sim_run_scenario(c, seed, path, cfg, 0, &p->res[i]);
+    }
+
+    free(c);
+    return NULL;
+}
+
+// LOCKSTEP
+// SIM_LANES babies per worker advance one controller step at a time. The controller stays scalar:
+// every lane keeps its own sim_ctx and runs its strategy's step on it. The plant update of move_to_cell /
+// converge_now and the BPM / CRY maps are done for all lanes at once on structure-of-arrays state,
+// written branch-free so the compiler turns each loop into AVX2 (8 lanes) or AVX-512 (16 lanes) code.
+// Only the original timing is modelled (move, converge, TAU, read): a delayed read TAU after the plant
+// settled sees S at the settle instant, so the lanes need no stress history. Results match the scalar
+// plant (-l) run for run.
+#if defined(__AVX512F__)
+#define SIM_LANES 16
+#else
+#define SIM_LANES 8
+#endif
+
+typedef struct sim_lanes
+{
+    // plant
+    double S[SIM_LANES];      // stress now
+    double t[SIM_LANES];      // lane clock
+    double S_read[SIM_LANES]; // what the delayed read of this step sees
+
+    // this step's move, gathered from the scalar decisions
+    double moved[SIM_LANES];  // 1.0 if the controller commanded a move
+    double pure[SIM_LANES];   // 1.0 if the move was purely softer or purely harder
+    double lo_old[SIM_LANES], hi_old[SIM_LANES];
+    double lo_new[SIM_LANES], hi_new[SIM_LANES];
+    double sopt_new[SIM_LANES], sopt9[SIM_LANES];
+
+    // results of the step
+    double panic[SIM_LANES];  // 1.0 if the move panicked
+    double t_settle[SIM_LANES];
+    double bpm[SIM_LANES];
+    double cry[SIM_LANES];
+} sim_lanes;
+
+// move_to_cell + converge_now + sensor maps for every lane, no branches.
+// lanes that did not move keep S and only wait TAU.
+static void lanes_plant_step(sim_lanes *restrict L, double tau, double motor_latency)
+{
+    for (int l = 0; l < SIM_LANES; l++)
+    {
+        double s = L->S[l];
+        double lo = L->lo_new[l], hi = L->hi_new[l];
+        int moved = L->moved[l] != 0.0;
+        int inside = (s >= lo) & (s <= hi);
+        int overlap = !((L->hi_old[l] < lo) | (L->lo_old[l] > hi));
+        int panic = moved & !inside & !overlap & (L->pure[l] != 0.0);
+
+        // clamped / kept, then converged to Sopt CONVERGENCE_TIME later; the read TAU after
+        // that instant sees Sopt (or Sopt[9] after a panic), like the change-point history does
+        double settled = panic ? L->sopt9[l] : L->sopt_new[l];
+        double dt = motor_latency + (panic ? 0.01 : CONVERGENCE_TIME);
+
+        L->S[l] = moved ? settled : s;
+        L->S_read[l] = moved ? settled : s;
+        L->panic[l] = panic ? 1.0 : 0.0;
+        L->t_settle[l] = L->t[l] + (moved ? dt : 0.0);
+        L->t[l] = L->t_settle[l] + tau;
+    }
+
+    // get_heartbeat / get_crying
+    for (int l = 0; l < SIM_LANES; l++)
+    {
+        double s = L->S[l];
+        L->bpm[l] = 60.0 + 1.8 * L->S_read[l];
+        L->cry[l] = (s >= 50 && s <= 100) ? 100.0 : ((s >= 10 && s <= 50) ? 2.5 * s - 25 : 0.0);
+    }
+}
+
+// start a lane on run i: scalar setup, first read TAU after start
+static void lane_start(sim_lanes *L, int l, sim_ctx *c, const batch_cfg *cfg, int i)
+{
+    unsigned seed;
+    int path;
+    batch_scenario(cfg, i, &seed, &path);
+    sim_setup_scenario(c, seed, path, cfg, 0);
+
+    L->S[l] = c->S;
+    L->S_read[l] = c->S;
+    L->t[l] = c->TAU;
+    c->sim_t = c->TAU;
+    c->S_tau_meas = c->S;
+    c->bpm_meas = (int)round(get_heartbeat(c, c->S));
+    c->cry_meas = (int)round(get_crying(c));
+}
+
+static void *lockstep_worker_main(batch_worker *w)
+{
+    batch_pool *p = w->pool;
+    const batch_cfg *cfg = p->cfg;
+
+    sim_ctx *c = malloc(SIM_LANES * sizeof(*c)); // scalar controller + matrix per lane
+    sim_lanes *L = calloc(1, sizeof(*L));
+    if (!c || !L)
+    {
+        free(c);
+        free(L);
+        return NULL;
+    }
+
+    int run[SIM_LANES]; // run index per lane, -1 = idle
+    int live = 0;
+    for (int l = 0; l < SIM_LANES; l++)
+    {
+        run[l] = next_run(p, w->id);
+        if (run[l] >= 0)
+        {
+            lane_start(L, l, &c[l], cfg, run[l]);
+            live++;
+        }
+    }
+
+    while (live > 0)
+    {
+        // scalar decisions, gather the commanded moves
+        for (int l = 0; l < SIM_LANES; l++)
+        {
+            L->moved[l] = 0.0;
+            if (run[l] < 0)
+                continue;
+            sim_ctx *cl = &c[l];
+            cl->steps++;
+            cl->strategy->step(cl, strategy_state(cl));
+            if (cl->evq_n == 0)
+                continue;
+
+            // command_motor queued EV_MOTOR_MOVE; the lane plant takes it from here
+            int a = cl->evq[0].a, f = cl->evq[0].f;
+            evq_clear(cl);
+            int oldK = cl->curK, newK = cl->K[a][f];
+            int softer = (a < cl->curA) | (f < cl->curF);
+            int harder = (a > cl->curA) | (f > cl->curF);
+            L->moved[l] = 1.0;
+            L->pure[l] = (softer != harder) ? 1.0 : 0.0;
+            L->lo_old[l] = cl->BandLow[oldK];
+            L->hi_old[l] = cl->BandHigh[oldK];
+            L->lo_new[l] = cl->BandLow[newK];
+            L->hi_new[l] = cl->BandHigh[newK];
+            L->sopt_new[l] = cl->Sopt[newK];
+            L->sopt9[l] = cl->Sopt[9];
+            cl->curA = a;
+            cl->curF = f;
+            cl->curK = newK;
+        }
+
+        lanes_plant_step(L, cfg->tau, cfg->motor_latency);
+
+        // scatter: calm / step limit, refill finished lanes
+        for (int l = 0; l < SIM_LANES; l++)
+        {
+            if (run[l] < 0)
+                continue;
+            sim_ctx *cl = &c[l];
+            cl->panic_count += (int)L->panic[l];
+            cl->S = L->S[l];
+
+            int done = 0;
+            if (cl->curA == 0 && cl->curF == 0 && cl->curK == 1)
+            {
+                cl->calm = 1;
+                cl->sim_t = L->t_settle[l];
+                done = 1;
+            }
+            else if (cl->steps >= MAX_CONTROLLER_STEPS)
+            {
+                cl->hit_limit = 1;
+                cl->sim_t = L->t_settle[l];
+                done = 1;
+            }
+            else
+            {
+                cl->sim_t = L->t[l];
+                cl->S_tau_meas = L->S_read[l];
+                cl->bpm_meas = (int)round(L->bpm[l]);
+                cl->cry_meas = (int)round(L->cry[l]);
+            }
+
+            if (done)
+            {
+                sim_collect_result(cl, cl->seed, cfg, &p->res[run[l]]);
+                run[l] = next_run(p, w->id);
+                if (run[l] >= 0)
+                    lane_start(L, l, cl, cfg, run[l]);
+                else
+                    live--;
+            }
+        }
+    }
+
+    free(c);
+    free(L);
+    return NULL;
+}
+
+// controller, and the timing when it differs from the original move -> converge -> TAU -> decide
+static void print_timing(const batch_cfg *cfg)
+{
+    printf("controller: %s (%s)\n", cfg->strategy->name, cfg->strategy->desc);
+    if (cfg->lockstep)
+        printf("lockstep: %d lanes per worker\n", SIM_LANES);
+    if (cfg->wake_period > 0)
+        printf("timing: controller wakes every %.1f s, motor latency %.2f s\n", cfg->wake_period, cfg->motor_latency);
+    else if (cfg->motor_latency > 0)
+        printf("timing: controller wakes %s, motor latency %.2f s\n",
+               cfg->strategy->period ? "on its own period" : "TAU after settle", cfg->motor_latency);
+}
+
+static double wall_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// nearest-rank percentile of a sorted array
+static double percentile(const double *v, int n, double pct)
+{
+    if (n <= 0)
+        return 0.0;
+    int r = (int)ceil(pct / 100.0 * n);
+    if (r < 1)
+        r = 1;
+    if (r > n)
+        r = n;
+    return v[r - 1];
+}
+
+static void print_percentiles(const char *name, double *v, int n)
+{
+    qsort(v, (size_t)n, sizeof(double), cmp_double);
+    double sum = 0.0;
+    for (int i = 0; i < n; i++)
+        sum += v[i];
+    printf("%-18s p50 %7.1f  p90 %7.1f  p95 %7.1f  p99 %7.1f  max %7.1f  mean %7.1f\n",
+           name, percentile(v, n, 50), percentile(v, n, 90), percentile(v, n, 95),
+           percentile(v, n, 99), n ? v[n - 1] : 0.0, n ? sum / n : 0.0);
+}
+
+// oracle comparison over the calm runs of a batch (needs -R)
+static void print_regret(const sim_result *res, int n)
+{
+    double *opt = malloc(sizeof(double) * (size_t)n);
+    double *reg = malloc(sizeof(double) * (size_t)n);
+    if (!opt || !reg)
+    {
+        free(opt);
+        free(reg);
+        return;
+    }
+
+    int nr = 0, at_opt = 0;
+    double sum_t = 0.0, sum_opt = 0.0;
+    const sim_result *worst = NULL;
+    for (int i = 0; i < n; i++)
+    {
+        if (!res[i].calm || res[i].t_opt < 0)
+            continue;
+        double r = res[i].t_calm - res[i].t_opt;
+        opt[nr] = res[i].t_opt;
+        reg[nr++] = r;
+        sum_t += res[i].t_calm;
+        sum_opt += res[i].t_opt;
+        if (r < 1e-6)
+            at_opt++;
+        if (!worst || r > worst->t_calm - worst->t_opt)
+            worst = &res[i];
+    }
+
+    print_percentiles("oracle optimum [s]", opt, nr);
+    print_percentiles("regret [s]", reg, nr);
+    if (worst)
+    {
+        char ps[PATH_MOVES + 1];
+        path_to_str(worst->path, ps);
+        printf("optimal runs %d (%.1f%%)  total regret %.1f%% of the optimum  worst: seed %u path %s (%.1f s vs %.1f s)\n",
+               at_opt, 100.0 * at_opt / nr, sum_opt > 0 ? 100.0 * (sum_t - sum_opt) / sum_opt : 0.0,
+               worst->seed, ps, worst->t_calm, worst->t_opt);
+    }
+
+    free(opt);
+    free(reg);
+}
+
+// summary of a finished batch
+static void batch_report(const batch_cfg *cfg, const sim_result *res, double wall)
+{
+    int n = cfg->runs;
+    double *t = malloc(sizeof(double) * (size_t)n);
+    double *st = malloc(sizeof(double) * (size_t)n);
+    if (!t || !st)
+    {
+        free(t);
+        free(st);
+        return;
+    }
+
+    int calm = 0, limit = 0, nt = 0;
+    long panics = 0, steps = 0;
+    double sim_secs = 0.0;
+    const sim_result *worst = NULL;
+    for (int i = 0; i < n; i++)
+    {
+        calm += res[i].calm;
+        limit += res[i].hit_limit;
+        panics += res[i].panics;
+        steps += res[i].steps;
+        sim_secs += res[i].t_calm;
+        st[i] = res[i].steps;
+        if (res[i].calm)
+        {
+            t[nt++] = res[i].t_calm;
+            if (!worst || res[i].t_calm > worst->t_calm)
+                worst = &res[i];
+        }
+    }
+
+    printf("batch: %d runs on %d threads, seeds %u..%u, TAU=%.1f s, thresholdBPM=%d\n",
+           n, cfg->threads, cfg->seed0, cfg->seed0 + (unsigned)n - 1, cfg->tau, cfg->thresholdBPM);
+    print_timing(cfg);
+    printf("calm %d (%.1f%%)  step-limit hit %d  panics/run %.2f\n",
+           calm, n ? 100.0 * calm / n : 0.0, limit, n ? (double)panics / n : 0.0);
+    print_percentiles("time-to-calm [s]", t, nt);
+    print_percentiles("controller steps", st, n);
+    if (worst)
+    {
+        char ps[PATH_MOVES + 1];
+        path_to_str(worst->path, ps);
+        printf("slowest calm run: seed %u path %s (%.1f s, %d steps, %d panics)\n",
+               worst->seed, ps, worst->t_calm, worst->steps, worst->panics);
+    }
+    if (cfg->regret)
+        print_regret(res, n);
+    printf("wall %.3f s  (%.0f runs/s, %.0f controller steps/s, %.0fx real time)\n", wall,
+           wall > 0 ? n / wall : 0.0, wall > 0 ? steps / wall : 0.0, wall > 0 ? sim_secs / wall : 0.0);
+
+    free(t);
+    free(st);
+}
+
+// -P: every forced panic has to be backed out, and at least one run has to have been forced
+static int watchdog_report(const sim_result *res, int n)
+{
+    int forced = 0, ok = 0, settled = 0;
+    for (int i = 0; i < n; i++)
+    {
+        forced += (res[i].backed_out != 0);
+        ok += (res[i].backed_out > 0);
+        settled += (res[i].backed_out > 0 && res[i].settled_step > 0);
+    }
+    int pass = forced > 0 && ok == forced && settled == forced;
+    printf("watchdog: forced a panic on a LEFT probe in %d runs, backed out to the probe's cell within %.1f s "
+           "in %d, next step on the converged cell in %d: %s\n", forced, WATCH_CHECK_SEC, ok, settled,
+           pass ? "PASS" : "FAIL");
+    return !pass;
+}
+
+// -r: every restart has to take its snapshot back and still calm, and at least one run has to restart
+static int restart_report(const sim_result *res, int n)
+{
+    int restarted = 0, restored = 0, calm = 0;
+    for (int i = 0; i < n; i++)
+    {
+        restarted += (res[i].restarted != 0);
+        restored += (res[i].restarted > 0);
+        calm += (res[i].restarted > 0 && res[i].calm);
+    }
+    int pass = restarted > 0 && restored == restarted && calm == restarted;
+    printf("restart: restarted the master before step %d in %d runs, snapshot restored in %d, calm after it "
+           "in %d: %s\n", RESTART_STEP, restarted, restored, calm, pass ? "PASS" : "FAIL");
+    return !pass;
+}
+
+// per-shape table for an exhaustive run: res holds PATH_SHAPES blocks of cfg->draws runs
+typedef struct shape_stats
+{
+    int path;
+    double mean_t;  // mean end time over all draws
+    double worst_t; // worst end time (a run that never calms counts with its end time)
+    unsigned worst_seed;
+    double panics;  // mean panics per run
+    int limit;      // runs that hit MAX_CONTROLLER_STEPS
+    double regret;  // mean end time minus mean oracle optimum (-R)
+} shape_stats;
+
+static int cmp_shape_worst(const void *a, const void *b)
+{
+    const shape_stats *x = a, *y = b;
+    if (x->worst_t != y->worst_t)
+        return (x->worst_t < y->worst_t) - (x->worst_t > y->worst_t);
+    return (x->mean_t < y->mean_t) - (x->mean_t > y->mean_t);
+}
+
+static void enum_report(const batch_cfg *cfg, const sim_result *res, double wall)
+{
+    shape_stats st[PATH_SHAPES];
+    double sum_all = 0.0;
+    int d = cfg->draws;
+
+    for (int s = 0; s < PATH_SHAPES; s++)
+    {
+        const sim_result *r = &res[s * d];
+        shape_stats *x = &st[s];
+        x->path = r[0].path;
+        x->worst_t = -1.0;
+        x->worst_seed = 0;
+        x->limit = 0;
+        double sum = 0.0, sum_opt = 0.0;
+        long panics = 0;
+        for (int i = 0; i < d; i++)
+        {
+            sum += r[i].t_calm;
+            sum_opt += r[i].t_opt;
+            panics += r[i].panics;
+            x->limit += r[i].hit_limit;
+            if (r[i].t_calm > x->worst_t)
+            {
+                x->worst_t = r[i].t_calm;
+                x->worst_seed = r[i].seed;
+            }
+        }
+        x->mean_t = sum / d;
+        x->panics = (double)panics / d;
+        x->regret = (sum - sum_opt) / d;
+        sum_all += sum;
+    }
+    qsort(st, PATH_SHAPES, sizeof(st[0]), cmp_shape_worst);
+
+    printf("exhaustive: %d path shapes x %d Sopt/band draws (seeds %u..%u) = %d runs on %d threads, TAU=%.1f s, thresholdBPM=%d\n",
+           PATH_SHAPES, d, cfg->seed0, cfg->seed0 + (unsigned)d - 1, cfg->runs, cfg->threads, cfg->tau, cfg->thresholdBPM);
+    print_timing(cfg);
+    printf("path       worst[s]  (seed)    mean[s]  panics/run  limit%s\n", cfg->regret ? "  regret[s]" : "");
+    for (int s = 0; s < PATH_SHAPES; s++)
+    {
+        char ps[PATH_MOVES + 1];
+        path_to_str(st[s].path, ps);
+        printf("%s  %8.1f  (%5u)  %8.1f  %10.2f  %5d",
+               ps, st[s].worst_t, st[s].worst_seed, st[s].mean_t, st[s].panics, st[s].limit);
+        if (cfg->regret)
+            printf("  %9.1f", st[s].regret);
+        printf("\n");
+    }
+    printf("overall worst %.1f s (first row), mean %.1f s\n",
+           st[0].worst_t, sum_all / cfg->runs);
+    if (cfg->regret)
+        print_regret(res, cfg->runs);
+    printf("wall %.3f s  (%.0f runs/s)\n", wall, wall > 0 ? cfg->runs / wall : 0.0);
+}
+
+// run every scenario of the batch on the pool, returns the wall time
+static double batch_pool_run(const batch_cfg *cfg, sim_result *res, batch_queue *q, batch_worker *w, pthread_t *tid)
+{
+    int n = cfg->runs, nt = cfg->threads;
+
+    // deal the runs out in equal contiguous slices, stealing evens out the rest
+    batch_pool pool = {cfg, q, res};
+    for (int i = 0; i < nt; i++)
+    {
+        pthread_mutex_init(&q[i].lock, NULL);
+        q[i].next = (int)((long)n * i / nt);
+        q[i].end = (int)((long)n * (i + 1) / nt);
+        w[i].pool = &pool;
+        w[i].id = i;
+    }
+
+    double t0 = wall_sec();
+    for (int i = 0; i < nt; i++)
+        pthread_create(&tid[i], NULL, batch_worker_main, &w[i]);
+    for (int i = 0; i < nt; i++)
+        pthread_join(tid[i], NULL);
+    double wall = wall_sec() - t0;
+
+    for (int i = 0; i < nt; i++)
+        pthread_mutex_destroy(&q[i].lock);
+    return wall;
+}
+
+// one row of the head-to-head table
+typedef struct strategy_summary
+{
+    const sim_strategy *strategy;
+    double calm_pct;
+    double p50, p95, mean; // time-to-calm over the calm runs
+    double panics;         // per run
+    double panic_pct;      // runs with at least one panic
+    double steps;          // mean controller steps
+    double regret;         // mean regret over the calm runs (-R), < 0 when not computed
+} strategy_summary;
+
+static void summarize(const sim_result *res, int n, strategy_summary *x)
+{
+    double *t = malloc(sizeof(double) * (size_t)(n > 0 ? n : 1));
+    int calm = 0, panicked = 0, nr = 0;
+    long panics = 0, steps = 0;
+    double sum = 0.0, sum_reg = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        panics += res[i].panics;
+        panicked += res[i].panics > 0;
+        steps += res[i].steps;
+        if (!res[i].calm)
+            continue;
+        if (t)
+            t[calm] = res[i].t_calm;
+        calm++;
+        sum += res[i].t_calm;
+        if (res[i].t_opt >= 0)
+        {
+            sum_reg += res[i].t_calm - res[i].t_opt;
+            nr++;
+        }
+    }
+    if (t)
+        qsort(t, (size_t)calm, sizeof(double), cmp_double);
+
+    x->calm_pct = n ? 100.0 * calm / n : 0.0;
+    x->p50 = t ? percentile(t, calm, 50) : 0.0;
+    x->p95 = t ? percentile(t, calm, 95) : 0.0;
+    x->mean = calm ? sum / calm : 0.0;
+    x->panics = n ? (double)panics / n : 0.0;
+    x->panic_pct = n ? 100.0 * panicked / n : 0.0;
+    x->steps = n ? (double)steps / n : 0.0;
+    x->regret = nr ? sum_reg / nr : -1.0;
+    free(t);
+}
+
+// every strategy ran the same seeds: time-to-calm is over each one's own calm runs, read it with calm%
+static void compare_report(const strategy_summary *x, int ns, int regret)
+{
+    printf("\nhead-to-head on identical scenarios (first row is the baseline):\n");
+    printf("strategy   calm%%   p50[s]   p95[s]  mean[s]  panics/run  panic%%   steps%s\n", regret ? "  regret[s]" : "");
+    for (int k = 0; k < ns; k++)
+    {
+        printf("%-8s  %5.1f  %7.1f  %7.1f  %7.1f  %10.2f  %6.1f  %6.1f",
+               x[k].strategy->name, x[k].calm_pct, x[k].p50, x[k].p95, x[k].mean,
+               x[k].panics, x[k].panic_pct, x[k].steps);
+        if (regret)
+            printf("  %9.1f", x[k].regret);
+        printf("\n");
+    }
+}
+
+// the batch once per strategy on the same scenarios, a report each, then the comparison
+static int batch_run(const batch_cfg *base, const sim_strategy *const *strategies, int ns)
+{
+    int n = base->runs, nt = base->threads;
+    sim_result *res = calloc((size_t)n, sizeof(*res));
+    batch_queue *q = calloc((size_t)nt, sizeof(*q));
+    batch_worker *w = calloc((size_t)nt, sizeof(*w));
+    pthread_t *tid = calloc((size_t)nt, sizeof(*tid));
+    strategy_summary *sum = calloc((size_t)ns, sizeof(*sum));
+    int rc = 0;
+    if (!res || !q || !w || !tid || !sum)
+    {
+        fprintf(stderr, "batch: out of memory\n");
+        free(res);
+        free(q);
+        free(w);
+        free(tid);
+        free(sum);
+        return 1;
+    }
+
+    for (int k = 0; k < ns; k++)
+    {
+        batch_cfg cfg = *base;
+        cfg.strategy = strategies[k];
+        double wall = batch_pool_run(&cfg, res, q, w, tid);
+
+        if (k > 0)
+            printf("\n");
+        if (cfg.draws > 0)
+            enum_report(&cfg, res, wall);
+        else
+            batch_report(&cfg, res, wall);
+        if (cfg.force_panic)
+            rc |= watchdog_report(res, n);
+        if (cfg.restart)
+            rc |= restart_report(res, n);
+        sum[k].strategy = cfg.strategy;
+        summarize(res, n, &sum[k]);
+    }
+    if (ns > 1)
+        compare_report(sum, ns, base->regret);
+
+    free(res);
+    free(q);
+    free(w);
+    free(tid);
+    free(sum);
+    return rc;
+}
+
+// POLICY GENERATOR (-G)
+// Writes ../decision/policy_table.h for CTRL_MODE_TABLE. Starting from policy_default, every state
+// the table strategy actually looks up (most visited first) gets each action tried on the same
+// scenarios, and the best one stays if it also lowers the cost on as many held-out seeds: a change
+// that only wins on the seeds it was tuned on is fitted to them. States a change newly reaches are
+// picked up by the next pass. A table that still does not beat policy_default on a third, fresh set
+// of seeds is not shipped, policy_default is. The cost charges what the cradle cares about: time to calm, plus a fixed price per panic and a
+// big one for a run that never calmed.
+#define POLICY_PANIC_COST 30.0 // s per panic
+#define POLICY_STUCK_COST 600.0 // s for a run that hit MAX_CONTROLLER_STEPS
+#define POLICY_PASSES 4
+
+static double policy_cost(const sim_result *res, int n)
+{
+    double sum = 0.0;
+    for (int i = 0; i < n; i++)
+        sum += res[i].t_calm + POLICY_PANIC_COST * res[i].panics + (res[i].calm ? 0.0 : POLICY_STUCK_COST);
+    return n ? sum / n : 0.0;
+}
+
+static const unsigned *policy_visits_sort; // qsort has no context argument
+
+static int cmp_visits(const void *a, const void *b)
+{
+    unsigned va = policy_visits_sort[*(const int *)a], vb = policy_visits_sort[*(const int *)b];
+    if (va != vb)
+        return (va < vb) ? 1 : -1;
+    return *(const int *)a - *(const int *)b;
+}
+
+static void policy_line(const char *what, const batch_cfg *cfg, const sim_result *res)
+{
+    strategy_summary x;
+    summarize(res, cfg->runs, &x);
+    printf("//   %-17s seeds %u..%u: calm %.1f%%, mean %.1f s, p95 %.1f s, %.2f panics/run, cost %.1f\n", what,
+           cfg->seed0, cfg->seed0 + (unsigned)cfg->runs - 1, x.calm_pct, x.mean, x.p95, x.panics,
+           policy_cost(res, cfg->runs));
+}
+
+static int policy_generate(const batch_cfg *base)
+{
+    int n = base->runs, nt = base->threads;
+    unsigned char *table = malloc(POLICY_STATES);
+    unsigned char *start = malloc(POLICY_STATES);
+    unsigned *visits = calloc(POLICY_STATES, sizeof(*visits));
+    int *order = malloc(sizeof(int) * POLICY_STATES);
+    sim_result *res = calloc((size_t)n, sizeof(*res));
+    batch_queue *q = calloc((size_t)nt, sizeof(*q));
+    batch_worker *w = calloc((size_t)nt, sizeof(*w));
+    pthread_t *tid = calloc((size_t)nt, sizeof(*tid));
+    if (!table || !start || !visits || !order || !res || !q || !w || !tid)
+    {
+        fprintf(stderr, "policy: out of memory\n");
+        free(table);
+        free(start);
+        free(visits);
+        free(order);
+        free(res);
+        free(q);
+        free(w);
+        free(tid);
+        return 1;
+    }
+
+    for (int i = 0; i < POLICY_STATES; i++)
+        start[i] = table[i] = policy_default(i);
+
+    batch_cfg cfg = *base;
+    cfg.strategy = strategy_find("table");
+    cfg.policy = table;
+    cfg.regret = 0;
+    batch_pool_run(&cfg, res, q, w, tid);
+    double best = policy_cost(res, n);
+    batch_cfg hc = cfg; // held out: the next n seeds
+    hc.seed0 = base->seed0 + (unsigned)n;
+    batch_pool_run(&hc, res, q, w, tid);
+    double best_held = policy_cost(res, n);
+    fprintf(stderr, "policy: policy_default costs %.2f on %d runs, %.2f held out\n", best, n, best_held);
+
+    for (int pass = 0; pass < POLICY_PASSES; pass++)
+    {
+        // which states does the current table reach, and how often (one thread: plain counters)
+        batch_cfg vc = cfg;
+        vc.threads = 1;
+        vc.policy_visits = visits;
+        memset(visits, 0, sizeof(*visits) * POLICY_STATES);
+        batch_pool_run(&vc, res, q, w, tid);
+
+        int nv = 0;
+        for (int i = 0; i < POLICY_STATES; i++)
+            if (visits[i])
+                order[nv++] = i;
+        policy_visits_sort = visits;
+        qsort(order, (size_t)nv, sizeof(int), cmp_visits);
+
+        int changed = 0;
+        for (int v = 0; v < nv; v++)
+        {
+            int i = order[v], keep = table[i];
+            for (int act = 0; act < POLICY_ACTIONS; act++)
+            {
+                if (act == keep)
+                    continue;
+                table[i] = (unsigned char)act;
+                batch_pool_run(&cfg, res, q, w, tid);
+                double cost = policy_cost(res, n);
+                if (cost >= best - 1e-9)
+                    continue;
+                batch_pool_run(&hc, res, q, w, tid);
+                double held = policy_cost(res, n);
+                if (held < best_held - 1e-9)
+                {
+                    best = cost;
+                    best_held = held;
+                    keep = act;
+                    changed++;
+                }
+            }
+            table[i] = (unsigned char)keep;
+        }
+        fprintf(stderr, "policy: pass %d, %d states visited, %d changed, cost %.2f, %.2f held out\n", pass + 1, nv,
+                changed, best, best_held);
+        if (!changed)
+            break;
+    }
+
+    // fresh seeds, neither tuned nor checked on: ship the table only if it beats policy_default there
+    batch_cfg vc = cfg;
+    vc.seed0 = base->seed0 + (unsigned)(2 * n);
+    vc.policy = start;
+    batch_pool_run(&vc, res, q, w, tid);
+    double fresh_default = policy_cost(res, n);
+    vc.policy = table;
+    batch_pool_run(&vc, res, q, w, tid);
+    int shipped = policy_cost(res, n) < fresh_default - 1e-9;
+    if (!shipped)
+        memcpy(table, start, POLICY_STATES);
+    fprintf(stderr, "policy: %s\n", shipped ? "table beats policy_default on fresh seeds"
+                                             : "table does not beat policy_default on fresh seeds, shipping the default");
+
+    // the header, with how it did on the training, held-out and fresh seeds
+    static const char *const set_name[3] = {"tuned on", "held out", "fresh"};
+    printf("// policy_table.h — GENERATED by ../sim/sim -G %d (make -C ../sim policy), do not edit.\n", n);
+    printf("// CTRL_MODE_TABLE policy (controller.c), indexed by POLICY_INDEX(cell, probe, trend, tried),\n"
+           "// actions POLICY_*. One line per anchor cell. %s on simulated babies:\n",
+           shipped ? "Tuned from policy_default" : "policy_default: no tuned table beat it on fresh seeds");
+    for (int set = 0; set < 3; set++)
+    {
+        char what[32];
+        vc.seed0 = base->seed0 + (unsigned)(set * n);
+        vc.policy = start;
+        batch_pool_run(&vc, res, q, w, tid);
+        snprintf(what, sizeof(what), "default, %s", set_name[set]);
+        policy_line(what, &vc, res);
+        vc.policy = table;
+        batch_pool_run(&vc, res, q, w, tid);
+        snprintf(what, sizeof(what), "table, %s", set_name[set]);
+        policy_line(what, &vc, res);
+    }
+    printf("\n#ifndef POLICY_TABLE_H\n#define POLICY_TABLE_H\n\n#define POLICY_TABLE_STATES %d\n\n", POLICY_STATES);
+    printf("static const unsigned char policy_table[POLICY_TABLE_STATES] = {\n");
+    for (int cell = 0; cell < 25; cell++)
+    {
+        printf("    // A%d F%d\n    ", cell / 5 + 1, cell % 5 + 1);
+        for (int j = 0; j < POLICY_STATES / 25; j++)
+            printf("%d,%s", table[cell * (POLICY_STATES / 25) + j], (j + 1 < POLICY_STATES / 25) ? " " : "\n");
+    }
+    printf("};\n\n#endif\n");
+
+    free(table);
+    free(start);
+    free(visits);
+    free(order);
+    free(res);
+    free(q);
+    free(w);
+    free(tid);
+    return 0;
+}
+
+static int cpu_count(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0)
+        return (int)n;
+#endif
+    return 1;
+}
+
+static void usage(const char *prog)
+{
+    printf("usage: %s                 one random scenario with full trace\n"
+           "       %s -s SEED         replay one scenario with full trace\n"
+           "       %s -b RUNS [-j THREADS] [-s SEED0] [-T TAU] [-t THRESHOLD_BPM]\n"
+           "                          Monte Carlo batch, prints a summary\n"
+           "       %s -e DRAWS [-j THREADS] [-s SEED0] [-T TAU] [-t THRESHOLD_BPM]\n"
+           "                          all 70 path shapes x DRAWS Sopt/band seeds, worst/mean table\n"
+           "       -p LLUULUUL        fix the K9->K1 path shape (L = LEFT, U = UP) for -s / -b\n"
+           "       -W SEC             wake the controller every SEC s instead of TAU after the plant settled\n"
+           "       -L SEC             motor latency between command and plant move (default 0)\n"
+           "       -V                 -b / -e on the lockstep SoA plant, %d babies per worker\n"
+           "       -R                 -b / -e also solve every matrix optimally (ORACLE) and report regret\n"
+           "       -P                 watchdog check: the first LEFT probe in the crying range panics, the next\n"
+           "                          command has to go back to the probe's cell within 1 s and the step after\n"
+           "                          it has to read the converged cell, exit 1 if not\n"
+           "       -r                 restart check: the master restarts before step %d and reloads its snapshot,\n"
+           "                          exit 1 if it refuses it or the run does not calm\n"
+           "       -c NAME[,NAME..]   controller strategy, default " DEFAULT_STRATEGY ". several (or 'all') run on the\n"
+           "                          same scenarios one after the other, -b / -e then print a head-to-head table\n"
+           "       -l                 same as -c legacy\n"
+           "       -G RUNS [-j THREADS] [-s SEED0]\n"
+           "                          tune the table strategy's policy on RUNS scenarios, print policy_table.h\n",
+           prog, prog, prog, prog, SIM_LANES, RESTART_STEP);
+    for (int i = 0; i < SIM_STRATEGIES; i++)
+        printf("                          %-8s %s\n", sim_strategies[i].name, sim_strategies[i].desc);
+}
+
+// parse -c: comma separated strategy names or "all". returns the count, -1 on an unknown name
+static int parse_strategies(const char *arg, const sim_strategy **out)
+{
+    if (!strcmp(arg, "all"))
+    {
+        for (int i = 0; i < SIM_STRATEGIES; i++)
+            out[i] = &sim_strategies[i];
+        return SIM_STRATEGIES;
+    }
+
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", arg);
+    int n = 0;
+    for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ","))
+    {
+        const sim_strategy *s = strategy_find(tok);
+        if (!s)
+        {
+            fprintf(stderr, "unknown controller strategy '%s'\n", tok);
+            return -1;
+        }
+        if (n < SIM_STRATEGIES)
+            out[n++] = s;
+    }
+    return n;
+}
+
+// one traced scenario, then the oracle's optimum for the same matrix. returns 1 if a -P / -r check failed
+static int single_run(const batch_cfg *cfg, unsigned seed)
+{
+    // ~33 KB of history per baby, keep it off the stack
+    static sim_ctx ctx;
+    sim_result r;
+    sim_run_scenario(&ctx, seed, cfg->path, cfg, 1, &r);
+
+    char ps[PATH_MOVES + 1];
+    path_to_str(r.path, ps);
+    printf("\nfinished at t = %.3f s. (seed %u, path %s)\n", now_sec(&ctx), seed, ps);
+
+    // panic-free optimum is the one regret is measured against, the panic-allowed one is just a bound
+    oracle_plan plan;
+    double t_opt = -1.0;
+    for (int allow = 0; allow <= 1; allow++)
+    {
+        double t = oracle_time_to_calm(&ctx, allow, &plan);
+        if (!allow)
+            t_opt = t;
+        if (t < 0)
+        {
+            printf("oracle%s: A1 F1 unreachable\n", allow ? " (panics allowed)" : "");
+            continue;
+        }
+        printf("oracle%s: optimum %.3f s in %d moves:", allow ? " (panics allowed)" : "", t, plan.n);
+        for (int m = 0; m < plan.n; m++)
+            printf(" A%dF%d%s", plan.cell[m] / 5 + 1, plan.cell[m] % 5 + 1, plan.panic[m] ? "(panic)" : "");
+        printf("\n");
+    }
+    if (r.calm && t_opt >= 0)
+        printf("regret %.3f s\n", r.t_calm - t_opt);
+    int rc = cfg->force_panic ? watchdog_report(&r, 1) : 0;
+    if (cfg->restart)
+        rc |= restart_report(&r, 1);
+    return rc;
+}
+
+int main(int argc, char **argv)
+{
+    batch_cfg cfg = {0, cpu_count(), 1, 10.0, 10, -1, 0, 0.0, 0.0, 0, 0, NULL, NULL, NULL, 0, 0};
+    int batch = 0, have_seed = 0, generate = 0;
+    const sim_strategy *strategies[SIM_STRATEGIES] = {strategy_find(DEFAULT_STRATEGY)};
+    int ns = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!strcmp(a, "-b") && v)
+        {
+            batch = 1;
+            cfg.runs = atoi(v);
+        }
+        else if (!strcmp(a, "-e") && v)
+        {
+            batch = 1;
+            cfg.draws = atoi(v);
+            cfg.runs = PATH_SHAPES * cfg.draws;
+        }
+        else if (!strcmp(a, "-G") && v)
+        {
+            generate = 1;
+            cfg.runs = atoi(v);
+        }
+        else if (!strcmp(a, "-p") && v)
+        {
+            cfg.path = path_from_str(v);
+            if (cfg.path < 0)
+            {
+                fprintf(stderr, "bad path '%s': need 8 moves, 4 x L and 4 x U\n", v);
+                return 1;
+            }
+        }
+        else if (!strcmp(a, "-j") && v)
+            cfg.threads = atoi(v);
+        else if (!strcmp(a, "-s") && v)
+        {
+            cfg.seed0 = (unsigned)strtoul(v, NULL, 10);
+            have_seed = 1;
+        }
+        else if (!strcmp(a, "-T") && v)
+            cfg.tau = atof(v);
+        else if (!strcmp(a, "-t") && v)
+            cfg.thresholdBPM = atoi(v);
+        else if (!strcmp(a, "-W") && v)
+            cfg.wake_period = atof(v);
+        else if (!strcmp(a, "-L") && v)
+            cfg.motor_latency = atof(v);
+        else if (!strcmp(a, "-c") && v)
+        {
+            ns = parse_strategies(v, strategies);
+            if (ns <= 0)
+                return 1;
+        }
+        else if (!strcmp(a, "-V"))
+        {
+            cfg.lockstep = 1;
+            continue; // no value
+        }
+        else if (!strcmp(a, "-R"))
+        {
+            cfg.regret = 1;
+            continue;
+        }
+        else if (!strcmp(a, "-P"))
+        {
+            cfg.force_panic = 1;
+            continue;
+        }
+        else if (!strcmp(a, "-r"))
+        {
+            cfg.restart = 1;
+            continue;
+        }
+        else if (!strcmp(a, "-l"))
+        {
+            strategies[0] = strategy_find("legacy");
+            ns = 1;
+            continue;
+        }
+        else
+        {
+            usage(argv[0]);
+            return (!strcmp(a, "-h")) ? 0 : 1;
+        }
+        i++;
+    }
+
+    for (int k = 0; k < ns && cfg.restart; k++)
+        if (!strategies[k]->restart)
+        {
+            fprintf(stderr, "-r: '%s' keeps nothing across a restart\n", strategies[k]->name);
+            return 1;
+        }
+
+    if (generate)
+    {
+        if (cfg.runs <= 0)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        if (cfg.threads < 1)
+            cfg.threads = 1;
+        if (cfg.threads > cfg.runs)
+            cfg.threads = cfg.runs;
+        return policy_generate(&cfg);
+    }
+
+    if (batch)
+    {
+        if (cfg.runs <= 0)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        for (int k = 0; k < ns && cfg.lockstep; k++)
+        {
+            // lanes only model move -> converge -> TAU -> decide, and calm without a panic veto
+            const sim_strategy *s = strategies[k];
+            if (cfg.wake_period > 0 || cfg.force_panic || cfg.restart || s->period || s->boot_step || s->panicked ||
+                s->settled)
+            {
+                fprintf(stderr, "-V only models the original wake-after-settle timing: '%s' has its own, or -W / -P / -r given\n",
+                        s->name);
+                return 1;
+            }
+        }
+        if (cfg.threads < 1)
+            cfg.threads = 1;
+        if (cfg.threads > cfg.runs)
+            cfg.threads = cfg.runs;
+        return batch_run(&cfg, strategies, ns);
+    }
+
+    // single traced run: every selected strategy on the same scenario
+    unsigned seed = have_seed ? cfg.seed0 : (unsigned)time(0);
+    int rc = 0;
+    for (int k = 0; k < ns; k++)
+    {
+        cfg.strategy = strategies[k];
+        if (ns > 1)
+            printf("%s=== controller: %s ===\n", k ? "\n" : "", cfg.strategy->name);
+        rc |= single_run(&cfg, seed);
+    }
+    return rc;
 }